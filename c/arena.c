@@ -0,0 +1,62 @@
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+
+void arena_init(struct arena* self) {
+    self->base = NULL;
+    self->capacity = 0;
+    self->used = 0;
+}
+
+// makes sure the arena can hold at least the given number of bytes. if the
+// current block is too small it is replaced which also resets the arena.
+int32_t arena_reserve(struct arena* self, size_t capacity) {
+    if (capacity <= self->capacity) {
+        return 0;
+    }
+
+    // aligned_alloc requires the size to be a multiple of the alignment
+    size_t rounded = (capacity + ARENA_ALIGN - 1) & ~((size_t)ARENA_ALIGN - 1);
+    char* base = (char*)aligned_alloc(ARENA_ALIGN, rounded);
+
+    if (base == NULL) {
+        fprintf(stderr, "failed allocating arena. %s\n", strerror(errno));
+
+        return 1;
+    }
+
+    free(self->base);
+
+    self->base = base;
+    self->capacity = rounded;
+    self->used = 0;
+
+    return 0;
+}
+
+// returns NULL if the arena does not have enough room left
+void* arena_alloc(struct arena* self, size_t size, size_t align) {
+    size_t offset = (self->used + align - 1) & ~(align - 1);
+
+    if (offset > self->capacity || size > self->capacity - offset) {
+        return NULL;
+    }
+
+    self->used = offset + size;
+
+    return self->base + offset;
+}
+
+void arena_reset(struct arena* self) {
+    self->used = 0;
+}
+
+void arena_free(struct arena* self) {
+    free(self->base);
+
+    arena_init(self);
+}
@@ -0,0 +1,25 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// alignment of the arena block and the default alignment of allocations so
+// buffers start on their own cache line
+#define ARENA_ALIGN 64
+
+// a single block of memory that is handed out in aligned pieces. everything
+// allocated from the arena is released at once when it is reset or freed.
+struct arena {
+    char* base;
+    size_t capacity;
+    size_t used;
+};
+
+void arena_init(struct arena* self);
+int32_t arena_reserve(struct arena* self, size_t capacity);
+void* arena_alloc(struct arena* self, size_t size, size_t align);
+void arena_reset(struct arena* self);
+void arena_free(struct arena* self);
+
+#endif
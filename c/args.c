@@ -8,7 +8,25 @@
 
 #include "args.h"
 
-void print_help() {
+static void print_help();
+static void print_full_help();
+static int32_t parse_threads_arg(const char* arg, int32_t* threads);
+static int32_t parse_iterations_arg(const char* arg, int32_t* iterations);
+static int32_t parse_cache_mb_arg(const char* arg, int32_t* cache_mb);
+static int32_t parse_check_edits_arg(const char* arg, int32_t* edits);
+static int32_t parse_isa_arg(const char* arg, int32_t* isa);
+static int32_t parse_format_arg(const char* arg, int32_t* format);
+static int32_t parse_trajectory_format_arg(const char* arg, int32_t* format);
+static int32_t parse_sweep_steps_arg(const char* arg, int32_t* steps, int32_t* len);
+static int32_t parse_sweep_algos_arg(const char* arg, int32_t* algos, int32_t* len);
+static int32_t parse_precision_arg(const char* arg, int32_t* precision);
+static int32_t parse_reduction_arg(const char* arg, int32_t* reduction);
+static int32_t parse_schedule_arg(const char* arg, int32_t* schedule, int32_t* chunk);
+static int32_t parse_bind_arg(const char* arg, int32_t* bind);
+static int32_t parse_sample_rate_arg(const char* arg, double* sample_rate);
+static int32_t parse_compress_tolerance_arg(const char* arg, double* tolerance);
+
+static void print_help() {
     printf(
 "an application for running \"train\" simulations of a givne acceleration\n"
 "profile that will calculate the final velocity and position of the train\n"
@@ -16,7 +34,9 @@ void print_help() {
 "Usage: sim [OPTIONS] <PATH>\n"
 "\n"
 "Arguments:\n"
-"  <PATH> the input file to load acceleration data from\n"
+"  <PATH> the input file to load acceleration data from. this can either be a\n"
+"         csv file or a binary profile. if not provided then the compiled in\n"
+"         acceleration data is used\n"
 "\n"
 "Options:\n"
 "  -t, --threads <THREADS> specifies the number of threads to use for\n"
@@ -27,11 +47,52 @@ void print_help() {
 "                          benchmarking purposes\n"
 "  -s, --step <STEP>       specifies the number of steps to take in bewteen each\n"
 "                          summation calculation [default: 10]\n"
+"  -c, --convert <OUT>     converts the loaded profile into a binary profile\n"
+"                          at the given path and exits\n"
+"      --sample-rate <HZ>  sample rate stored in converted profiles\n"
+"                          [default: 1]\n"
+"      --isa <ISA>         the instruction set used by the summation kernels\n"
+"                          [default: auto]\n"
+"  -f, --fused             computes velocity and position in a single pass\n"
+"                          without a velocity table\n"
+"  -b, --batch <MANIFEST>  runs every job listed in the manifest\n"
+"      --format <FORMAT>   output format for batch results [default: csv]\n"
+"  -o, --trajectory <OUT>  writes the velocity and position at every entry of\n"
+"                          the profile to the given path\n"
+"      --trajectory-format <FORMAT>\n"
+"                          output format for the trajectory [default: binary]\n"
+"      --compress          simulates the linear runs of the profile in closed\n"
+"                          form instead of each entry\n"
+"      --compress-tolerance <TOL>\n"
+"                          error allowed when fitting runs [default: 1e-9]\n"
+"      --precision <PREC>  precision the profile is simulated in [default: double]\n"
+"      --reduction <MODE>  how per thread results are combined [default: thread]\n"
+"      --schedule <KIND[,CHUNK]>\n"
+"                          schedule and block size of the block loops\n"
+"      --bind <BIND>       pins the threads to cpus [default: none]\n"
+"      --persistent        runs every iteration in one parallel region\n"
+"      --profile           prints timings for each phase of the simulation\n"
+"      --cycles            adds time stamp counter cycles to --profile\n"
+"      --perf              adds hardware counters to --profile\n"
+"      --sweep <STEPS>     runs every algo with each of the steps in one pass\n"
+"      --sweep-algos <LIST>\n"
+"                          the algos of --sweep [default: the five fixed rules]\n"
+"      --profile-out <OUT> writes the phase timings to the given path\n"
+"      --offload           runs the simulation on the default offload device\n"
+"      --fleet <LIST>      simulates every profile in the list together\n"
+"      --serve <SOCKET>    answers position queries on a unix socket\n"
+"      --cache-mb <MB>     memory for the cached trajectories of --serve\n"
+"                          [default: 256]\n"
+"      --index-out <OUT>   writes a position index of the profile to the path\n"
+"      --index <INDEX>     answers position queries from stdin with an index\n"
+"      --stream            integrates a csv profile while it is being read\n"
+"      --check-incremental <EDITS>\n"
+"                          checks incremental updates against full runs\n"
     );
 
 }
 
-void print_full_help() {
+static void print_full_help() {
     printf(
 "an application for running \"train\" simulations of a givne acceleration\n"
 "profile that will calculate the final velocity and position of the train\n"
@@ -39,7 +100,9 @@ void print_full_help() {
 "Usage: sim [OPTIONS] <PATH>\n"
 "\n"
 "Arguments:\n"
-"  <PATH> the input file to load acceleration data from\n"
+"  <PATH> the input file to load acceleration data from. this can either be a\n"
+"         csv file or a binary profile. if not provided then the compiled in\n"
+"         acceleration data is used\n"
 "\n"
 "Options:\n"
 "\n"
@@ -49,7 +112,10 @@ void print_full_help() {
 "  -a, --algo <ALGO>\n"
 "        specifies the summation algorithm to use for the simulation\n"
 "        [default: left-riemann] [possible-values: left-riemann, mid-riemann,\n"
-"        right-riemann, trapezoidal, simpsons]\n"
+"        right-riemann, trapezoidal, simpsons, exact]\n"
+"\n"
+"        exact integrates the piecewise linear acceleration and the resulting\n"
+"        piecewise quadratic velocity in closed form so --step is ignored\n"
 "\n"
 "  -i, --iterations <ITER>\n"
 "        specifies the number times to run the program, for benchmarking purposes\n"
@@ -57,31 +123,296 @@ void print_full_help() {
 "  -s, --step <STEP>\n"
 "        specifies the number of steps to take in bewteen each summation\n"
 "        calculation [default: 10]\n"
+"\n"
+"  -c, --convert <OUT>\n"
+"        converts the loaded profile into a binary profile at the given path\n"
+"        and exits. binary profiles are memory mapped when loaded so they will\n"
+"        not need to be parsed on every run\n"
+"\n"
+"      --sample-rate <HZ>\n"
+"        the sample rate in hertz to store in the header of converted profiles\n"
+"        [default: the rate of the loaded profile or 1]\n"
+"\n"
+"      --isa <ISA>\n"
+"        the instruction set used by the summation kernels. auto will pick the\n"
+"        widest one supported by the cpu [default: auto] [possible-values:\n"
+"        auto, scalar, avx2, avx512, neon]\n"
+"\n"
+"  -f, --fused\n"
+"        computes velocity and position together in a single pass over the\n"
+"        acceleration data. only the velocity at either end of the current\n"
+"        interval is kept so no velocity table is allocated and the data is\n"
+"        only read once\n"
+"\n"
+"  -b, --batch <MANIFEST>\n"
+"        runs every job listed in the manifest file in a single process. each\n"
+"        line is a job in the form \"path[,algo[,step]]\" where algo and step\n"
+"        default to the values given on the command line. each profile is\n"
+"        loaded once and the jobs are spread across --threads threads with\n"
+"        every job running on a single thread. lines starting with # are\n"
+"        skipped and lines longer than 4094 bytes are rejected\n"
+"\n"
+"      --format <FORMAT>\n"
+"        the output format of batch results, one line per job as it finishes\n"
+"        [default: csv] [possible-values: csv, json]\n"
+"\n"
+"  -o, --trajectory <OUT>\n"
+"        runs the simulation once and writes the time, acceleration, velocity\n"
+"        and position at every entry of the profile to the given path. the\n"
+"        samples are written by a separate thread while the simulation\n"
+"        continues so --iterations is ignored\n"
+"\n"
+"      --trajectory-format <FORMAT>\n"
+"        the format of the trajectory file. binary files start with a 24 byte\n"
+"        header followed by 4 little-endian doubles per sample\n"
+"        [default: binary] [possible-values: binary, csv]\n"
+"\n"
+"      --compress\n"
+"        stores the profile as its maximal linear runs of (value, slope,\n"
+"        length) and integrates each run of the selected algorithm in closed\n"
+"        form. profiles made of constant acceleration and linear ramps only\n"
+"        need a few runs. the result matches the uncompressed simulation up to\n"
+"        rounding when the tolerance is 0. when the runs would take at least\n"
+"        as much memory as the profile the profile is simulated as is\n"
+"\n"
+"      --compress-tolerance <TOL>\n"
+"        the largest difference allowed between an entry of the profile and\n"
+"        the run it is part of [default: 1e-9]\n"
+"\n"
+"      --precision <PREC>\n"
+"        the precision the profile is stored and simulated in. float stores\n"
+"        the profile in single precision and evaluates and sums every interval\n"
+"        in single precision with kahan compensation. mixed stores and\n"
+"        evaluates the acceleration in single precision but keeps the\n"
+"        velocity and position in double. both run a single threaded fused\n"
+"        pass of the fixed step algorithms and report their error against the\n"
+"        double precision result [default: double] [possible-values: double,\n"
+"        float, mixed]\n"
+"\n"
+"      --reduction <MODE>\n"
+"        how the results of each block of the table are combined. thread uses\n"
+"        one block per thread so the result changes with --threads. pairwise\n"
+"        and kahan split the table into blocks of a fixed size and combine\n"
+"        them as a balanced tree or in order with kahan compensation so the\n"
+"        result is bit for bit the same for any number of threads, including\n"
+"        a single thread. without --fused the start velocity of every block\n"
+"        is needed, so both build it with a sequential kahan scan of the\n"
+"        block totals and only the position totals are combined by the mode\n"
+"        [default: thread] [possible-values: thread, pairwise, kahan]\n"
+"\n"
+"      --schedule <KIND[,CHUNK]>\n"
+"        the OpenMP schedule of the loops over blocks of the table, which are\n"
+"        the position pass and every loop of the pairwise and kahan\n"
+"        reductions. CHUNK is the number of intervals in each block and is\n"
+"        rounded up to a whole number of cache lines [default: one block per\n"
+"        thread] [possible-values: static, dynamic, guided]\n"
+"\n"
+"      --bind <BIND>\n"
+"        pins each thread to a single cpu from the set the process is allowed\n"
+"        to run on. close places the threads on neighbouring cpus and spread\n"
+"        spaces them evenly over all of them, which puts them on different\n"
+"        sockets on multi socket machines [default: none] [possible-values:\n"
+"        none, close, spread]\n"
+"\n"
+"      --persistent\n"
+"        runs all of the iterations inside of a single parallel region with\n"
+"        barriers between the phases instead of starting new regions for each\n"
+"        phase of every iteration. this removes the fork and join cost that\n"
+"        dominates small profiles. only used with --reduction thread and more\n"
+"        than one thread\n"
+"\n"
+"      --profile\n"
+"        times each phase of every iteration on its own (velocity, scan,\n"
+"        position, fused, join and the whole iteration) and prints the\n"
+"        average and the p50, p90, p99 and p99.9 latencies of each. the\n"
+"        percentiles come from a log linear histogram accurate to about 6%%\n"
+"\n"
+"      --cycles\n"
+"        reads the time stamp counter around each phase as well and prints\n"
+"        the average cycles per phase. implies --profile\n"
+"\n"
+"      --perf\n"
+"        opens the cycles, instructions, last level cache misses and branch\n"
+"        misses counters with perf_event_open and reads them around each\n"
+"        phase, printing the instructions per cycle and the misses per entry\n"
+"        of the profile. the run continues without them when the kernel does\n"
+"        not allow it. implies --profile\n"
+"\n"
+"      --sweep <STEPS>\n"
+"        a comma separated list of steps. every algo of --sweep-algos is run\n"
+"        with every step in a single pass over the profile along with the\n"
+"        exact kernel. prints the velocity and position of each combination,\n"
+"        their error against exact and the order of convergence against the\n"
+"        previous step of the same algo in the format given by --format\n"
+"\n"
+"      --sweep-algos <LIST>\n"
+"        a comma separated list of the algos run by --sweep [default:\n"
+"        left-riemann, mid-riemann, right-riemann, trapezoidal, simpsons]\n"
+"\n"
+"      --profile-out <OUT>\n"
+"        writes the phase timings in nanoseconds to the given path in the\n"
+"        format given by --format. implies --profile\n"
+"\n"
+"      --offload\n"
+"        copies the profile to the default openmp offload device once and runs\n"
+"        every iteration there with a blocked scan of the velocity. prints the\n"
+"        upload, kernel and download times so they can be weighed against the\n"
+"        host runners. without a device the target regions run on the host\n"
+"\n"
+"      --fleet <LIST>\n"
+"        a file with the path of a profile on each line. every profile must\n"
+"        have the same length and they are interleaved so each vector\n"
+"        instruction advances several trains at once, with the threads split\n"
+"        across blocks of trains. prints the velocity and position of every\n"
+"        train in the format given by --format\n"
+"\n"
+"      --serve <SOCKET>\n"
+"        runs as a server on the given unix socket until interrupted. each\n"
+"        request is a line of text:\n"
+"          at <FILE> <ALGO> <STEP> <TIME>...\n"
+"          range <FILE> <ALGO> <STEP> <FROM> <TO> <N>\n"
+"          stats\n"
+"        the first request for a file, algo and step simulates the state at\n"
+"        every entry of the profile once and later requests interpolate\n"
+"        inside of the cached result. requests that arrive while it is being\n"
+"        computed wait for it instead of computing it again. a file is\n"
+"        recognised by its device and inode whatever path names it, and a\n"
+"        file that was modified since it was cached is simulated again.\n"
+"        times are in entries of the profile and a request longer than 4095\n"
+"        bytes is answered with err line too long\n"
+"\n"
+"      --cache-mb <MB>\n"
+"        the memory the cached results of --serve are allowed to take before\n"
+"        the least recently used ones are dropped. a result larger than the\n"
+"        whole cache is only kept for the requests that asked for it\n"
+"        [default: 256]\n"
+"\n"
+"      --index-out <OUT>\n"
+"        simulates the profile once with the selected algo and step and writes\n"
+"        the position at every entry along with the cubic of each interval\n"
+"        and the runs where the position only moves one way to the path\n"
+"\n"
+"      --index <INDEX>\n"
+"        maps an index written by --index-out and answers the queries read\n"
+"        from stdin, one per line:\n"
+"          at <TIME>...              ok <VEL> <POS>...\n"
+"          time <POS> [AFTER]        ok <TIME> of the first time at or after\n"
+"                                    AFTER the train is at POS\n"
+"        times are in entries of the profile\n"
+"\n"
+"      --stream\n"
+"        reads the csv profile from a separate thread in chunks of 65536\n"
+"        entries and runs the fused pass over each chunk as soon as it has\n"
+"        been parsed, carrying the velocity and position from one chunk to\n"
+"        the next, so the file never has to be held in memory and reading it\n"
+"        overlaps with the simulation\n"
+"\n"
+"      --check-incremental <EDITS>\n"
+"        replaces EDITS random runs of up to 64 entries of the profile one\n"
+"        after the other through the incremental simulation and compares its\n"
+"        final velocity and position after each against a full simulation of\n"
+"        the edited profile with the selected algo, step and threads. prints\n"
+"        the largest relative errors and fails if either is above 1e-9\n"
     );
 }
 
+// the defaults every simulation starts from. embedders should call this before
+// setting the fields they care about so fields added later keep their
+// defaults
+void sim_args_init(struct sim_args* self) {
+    self->threads = 1;
+    self->algo = 0;
+    self->step = 10;
+    self->iterations = 1;
+    self->isa = ISA_AUTO;
+    self->fused = 0;
+    self->reduction = REDUCTION_THREAD;
+    self->schedule = SCHEDULE_DEFAULT;
+    self->chunk = 0;
+    self->bind = BIND_NONE;
+    self->persistent = 0;
+    self->profile = 0;
+    self->cycles = 0;
+    self->perf = 0;
+    self->profile_path = NULL;
+    self->profile_format = FORMAT_CSV;
+}
+
 int32_t app_args_init(struct app_args* self, int argc, char** argv) {
     self->file_path = NULL;
-    self->sim.threads = 1;
-    self->sim.algo = 0;
-    self->sim.step = 10;
-    self->sim.iterations = 1;
+    self->convert_path = NULL;
+    self->batch_path = NULL;
+    self->trajectory_path = NULL;
+    self->fleet_path = NULL;
+    self->serve_path = NULL;
+    self->index_out_path = NULL;
+    self->index_path = NULL;
+    self->cache_mb = SERVER_DEFAULT_CACHE_MB;
+    self->format = FORMAT_CSV;
+    self->trajectory_format = TRAJECTORY_BINARY;
+    self->precision = PRECISION_DOUBLE;
+    self->compress = 0;
+    self->compress_tolerance = COMPRESS_DEFAULT_TOLERANCE;
+    self->offload = 0;
+    self->stream = 0;
+    self->check_edits = 0;
+    // zero indicates that the sample rate of the loaded profile is kept
+    self->sample_rate = 0.0;
+    self->sweep_steps_len = 0;
+    self->sweep_algos_len = 0;
+
+    for (int32_t algo = LEFT_RIEMANN; algo <= SIMPSONS; algo += 1) {
+        self->sweep_algos[self->sweep_algos_len] = algo;
+        self->sweep_algos_len += 1;
+    }
+
+    sim_args_init(&self->sim);
 
     struct option long_options[] = {
         {"threads", required_argument, 0, 0 },
         {"step", required_argument, 0, 0 },
         {"iterations", required_argument, 0, 0 },
         {"algo", required_argument, 0, 0 },
-        {"help", no_argument, 0, 0}
+        {"help", no_argument, 0, 0},
+        {"convert", required_argument, 0, 0 },
+        {"sample-rate", required_argument, 0, 0 },
+        {"isa", required_argument, 0, 0 },
+        {"fused", no_argument, 0, 0 },
+        {"batch", required_argument, 0, 0 },
+        {"format", required_argument, 0, 0 },
+        {"trajectory", required_argument, 0, 0 },
+        {"trajectory-format", required_argument, 0, 0 },
+        {"compress", no_argument, 0, 0 },
+        {"compress-tolerance", required_argument, 0, 0 },
+        {"precision", required_argument, 0, 0 },
+        {"reduction", required_argument, 0, 0 },
+        {"schedule", required_argument, 0, 0 },
+        {"bind", required_argument, 0, 0 },
+        {"persistent", no_argument, 0, 0 },
+        {"profile", no_argument, 0, 0 },
+        {"cycles", no_argument, 0, 0 },
+        {"profile-out", required_argument, 0, 0 },
+        {"perf", no_argument, 0, 0 },
+        {"sweep", required_argument, 0, 0 },
+        {"sweep-algos", required_argument, 0, 0 },
+        {"offload", no_argument, 0, 0 },
+        {"fleet", required_argument, 0, 0 },
+        {"serve", required_argument, 0, 0 },
+        {"cache-mb", required_argument, 0, 0 },
+        {"index-out", required_argument, 0, 0 },
+        {"index", required_argument, 0, 0 },
+        {"stream", no_argument, 0, 0 },
+        {"check-incremental", required_argument, 0, 0 },
+        {0, 0, 0, 0}
     };
 
     int32_t option_index = 0;
 
     while (1) {
-        int32_t c = getopt_long(argc, argv, "t:s:i:a:h:", long_options, &option_index);
+        int32_t c = getopt_long(argc, argv, "t:s:i:a:c:fb:o:h", long_options, &option_index);
 
         if (c == -1) {
-            return 0;
+            break;
         }
 
         switch (c) {
@@ -93,7 +424,7 @@ int32_t app_args_init(struct app_args* self, int argc, char** argv) {
                 }
                 break;
             case 1:
-                if (parse_step_arg(optarg, &self->sim.step) != 0) {
+                if (args_parse_step(optarg, &self->sim.step) != 0) {
                     return 1;
                 }
                 break;
@@ -103,7 +434,7 @@ int32_t app_args_init(struct app_args* self, int argc, char** argv) {
                 }
                 break;
             case 3:
-                if (parse_algo_arg(optarg, &self->sim.algo) != 0) {
+                if (args_parse_algo(optarg, &self->sim.algo) != 0) {
                     return 1;
                 }
                 break;
@@ -111,6 +442,122 @@ int32_t app_args_init(struct app_args* self, int argc, char** argv) {
                 print_full_help();
 
                 return 1;
+            case 5:
+                self->convert_path = optarg;
+                break;
+            case 6:
+                if (parse_sample_rate_arg(optarg, &self->sample_rate) != 0) {
+                    return 1;
+                }
+                break;
+            case 7:
+                if (parse_isa_arg(optarg, &self->sim.isa) != 0) {
+                    return 1;
+                }
+                break;
+            case 8:
+                self->sim.fused = 1;
+                break;
+            case 9:
+                self->batch_path = optarg;
+                break;
+            case 10:
+                if (parse_format_arg(optarg, &self->format) != 0) {
+                    return 1;
+                }
+                break;
+            case 11:
+                self->trajectory_path = optarg;
+                break;
+            case 12:
+                if (parse_trajectory_format_arg(optarg, &self->trajectory_format) != 0) {
+                    return 1;
+                }
+                break;
+            case 13:
+                self->compress = 1;
+                break;
+            case 14:
+                if (parse_compress_tolerance_arg(optarg, &self->compress_tolerance) != 0) {
+                    return 1;
+                }
+                break;
+            case 15:
+                if (parse_precision_arg(optarg, &self->precision) != 0) {
+                    return 1;
+                }
+                break;
+            case 16:
+                if (parse_reduction_arg(optarg, &self->sim.reduction) != 0) {
+                    return 1;
+                }
+                break;
+            case 17:
+                if (parse_schedule_arg(optarg, &self->sim.schedule, &self->sim.chunk) != 0) {
+                    return 1;
+                }
+                break;
+            case 18:
+                if (parse_bind_arg(optarg, &self->sim.bind) != 0) {
+                    return 1;
+                }
+                break;
+            case 19:
+                self->sim.persistent = 1;
+                break;
+            case 20:
+                self->sim.profile = 1;
+                break;
+            case 21:
+                self->sim.profile = 1;
+                self->sim.cycles = 1;
+                break;
+            case 22:
+                self->sim.profile = 1;
+                self->sim.profile_path = optarg;
+                break;
+            case 23:
+                self->sim.profile = 1;
+                self->sim.perf = 1;
+                break;
+            case 24:
+                if (parse_sweep_steps_arg(optarg, self->sweep_steps, &self->sweep_steps_len) != 0) {
+                    return 1;
+                }
+                break;
+            case 25:
+                if (parse_sweep_algos_arg(optarg, self->sweep_algos, &self->sweep_algos_len) != 0) {
+                    return 1;
+                }
+                break;
+            case 26:
+                self->offload = 1;
+                break;
+            case 27:
+                self->fleet_path = optarg;
+                break;
+            case 28:
+                self->serve_path = optarg;
+                break;
+            case 29:
+                if (parse_cache_mb_arg(optarg, &self->cache_mb) != 0) {
+                    return 1;
+                }
+                break;
+            case 30:
+                self->index_out_path = optarg;
+                break;
+            case 31:
+                self->index_path = optarg;
+                break;
+            case 32:
+                self->stream = 1;
+                break;
+            case 33:
+                if (parse_check_edits_arg(optarg, &self->check_edits) != 0) {
+                    return 1;
+                }
+                break;
             }
             break;
         case 't':
@@ -119,7 +566,7 @@ int32_t app_args_init(struct app_args* self, int argc, char** argv) {
             }
             break;
         case 's':
-            if (parse_step_arg(optarg, &self->sim.step) != 0) {
+            if (args_parse_step(optarg, &self->sim.step) != 0) {
                 return 1;
             }
             break;
@@ -129,10 +576,22 @@ int32_t app_args_init(struct app_args* self, int argc, char** argv) {
             }
             break;
         case 'a':
-            if (parse_algo_arg(optarg, &self->sim.algo) != 0) {
+            if (args_parse_algo(optarg, &self->sim.algo) != 0) {
                 return 1;
             }
             break;
+        case 'c':
+            self->convert_path = optarg;
+            break;
+        case 'f':
+            self->sim.fused = 1;
+            break;
+        case 'b':
+            self->batch_path = optarg;
+            break;
+        case 'o':
+            self->trajectory_path = optarg;
+            break;
         case 'h':
             print_help();
 
@@ -144,13 +603,20 @@ int32_t app_args_init(struct app_args* self, int argc, char** argv) {
         }
     }
 
+    if (optind < argc) {
+        self->file_path = argv[optind];
+    }
+
+    // the phase timings are written in the same format as batch results
+    self->sim.profile_format = self->format;
+
     return 0;
 }
 
-int32_t parse_threads_arg(const char* arg, int32_t* threads) {
-    long parsed = 0;
+static int32_t parse_threads_arg(const char* arg, int32_t* threads) {
+    int64_t parsed = 0;
 
-    if (parse_l(arg, &parsed) != 0) {
+    if (args_parse_l(arg, &parsed) != 0) {
         fprintf(stderr, "invalid thread size provided\n");
 
         return 1;
@@ -167,7 +633,7 @@ int32_t parse_threads_arg(const char* arg, int32_t* threads) {
     return 0;
 }
 
-int32_t parse_algo_arg(const char* arg, int32_t* algo) {
+int32_t args_parse_algo(const char* arg, int32_t* algo) {
     if (strncmp(arg, "left-riemann", 13) == 0) {
         *algo = LEFT_RIEMANN;
     } else if (strncmp(arg, "mid-riemann", 12) == 0) {
@@ -178,6 +644,8 @@ int32_t parse_algo_arg(const char* arg, int32_t* algo) {
         *algo = TRAPEZOIDAL;
     } else if (strncmp(arg, "simpsons", 9) == 0) {
         *algo = SIMPSONS;
+    } else if (strncmp(arg, "exact", 6) == 0) {
+        *algo = EXACT;
     } else {
         fprintf(stderr, "invalid algo provided\n");
 
@@ -187,10 +655,10 @@ int32_t parse_algo_arg(const char* arg, int32_t* algo) {
     return 0;
 }
 
-int32_t parse_step_arg(const char* arg, int32_t* step) {
-    long parsed = 0;
+int32_t args_parse_step(const char* arg, int32_t* step) {
+    int64_t parsed = 0;
 
-    if (parse_l(arg, &parsed) != 0) {
+    if (args_parse_l(arg, &parsed) != 0) {
         fprintf(stderr, "invalid step provided\n");
 
         return 1;
@@ -207,10 +675,10 @@ int32_t parse_step_arg(const char* arg, int32_t* step) {
     return 0;
 }
 
-int32_t parse_iterations_arg(const char* arg, int32_t* iterations) {
-    long parsed = 0;
+static int32_t parse_iterations_arg(const char* arg, int32_t* iterations) {
+    int64_t parsed = 0;
 
-    if (parse_l(arg, &parsed) != 0) {
+    if (args_parse_l(arg, &parsed) != 0) {
         fprintf(stderr, "invalid iterations provided\n");
 
         return 1;
@@ -228,15 +696,277 @@ int32_t parse_iterations_arg(const char* arg, int32_t* iterations) {
 
 }
 
-int parse_l(const char* str, long* value) {
+static int32_t parse_cache_mb_arg(const char* arg, int32_t* cache_mb) {
+    int64_t parsed = 0;
+
+    if (args_parse_l(arg, &parsed) != 0 || parsed > INT32_MAX || parsed < 1) {
+        fprintf(stderr, "invalid cache size provided\n");
+
+        return 1;
+    }
+
+    *cache_mb = parsed;
+
+    return 0;
+}
+
+static int32_t parse_check_edits_arg(const char* arg, int32_t* edits) {
+    int64_t parsed = 0;
+
+    if (args_parse_l(arg, &parsed) != 0 || parsed > INT32_MAX || parsed < 1) {
+        fprintf(stderr, "invalid number of edits provided\n");
+
+        return 1;
+    }
+
+    *edits = parsed;
+
+    return 0;
+}
+
+static int32_t parse_isa_arg(const char* arg, int32_t* isa) {
+    if (strncmp(arg, "auto", 5) == 0) {
+        *isa = ISA_AUTO;
+    } else if (strncmp(arg, "scalar", 7) == 0) {
+        *isa = ISA_SCALAR;
+    } else if (strncmp(arg, "avx2", 5) == 0) {
+        *isa = ISA_AVX2;
+    } else if (strncmp(arg, "avx512", 7) == 0) {
+        *isa = ISA_AVX512;
+    } else if (strncmp(arg, "neon", 5) == 0) {
+        *isa = ISA_NEON;
+    } else {
+        fprintf(stderr, "invalid isa provided\n");
+
+        return 1;
+    }
+
+    return 0;
+}
+
+static int32_t parse_format_arg(const char* arg, int32_t* format) {
+    if (strncmp(arg, "csv", 4) == 0) {
+        *format = FORMAT_CSV;
+    } else if (strncmp(arg, "json", 5) == 0) {
+        *format = FORMAT_JSON;
+    } else {
+        fprintf(stderr, "invalid format provided\n");
+
+        return 1;
+    }
+
+    return 0;
+}
+
+static int32_t parse_trajectory_format_arg(const char* arg, int32_t* format) {
+    if (strncmp(arg, "binary", 7) == 0) {
+        *format = TRAJECTORY_BINARY;
+    } else if (strncmp(arg, "csv", 4) == 0) {
+        *format = TRAJECTORY_CSV;
+    } else {
+        fprintf(stderr, "invalid trajectory format provided\n");
+
+        return 1;
+    }
+
+    return 0;
+}
+
+// parses a comma separated list of steps
+static int32_t parse_sweep_steps_arg(const char* arg, int32_t* steps, int32_t* len) {
+    char buffer[1024];
+
+    if (strlen(arg) >= sizeof(buffer)) {
+        fprintf(stderr, "invalid sweep steps provided\n");
+
+        return 1;
+    }
+
+    strcpy(buffer, arg);
+
+    *len = 0;
+
+    for (char* item = strtok(buffer, ","); item != NULL; item = strtok(NULL, ",")) {
+        if (*len == SWEEP_MAX_LEN) {
+            fprintf(stderr, "invalid sweep steps provided\n");
+
+            return 1;
+        }
+
+        if (args_parse_step(item, &steps[*len]) != 0) {
+            return 1;
+        }
+
+        *len += 1;
+    }
+
+    if (*len == 0) {
+        fprintf(stderr, "invalid sweep steps provided\n");
+
+        return 1;
+    }
+
+    return 0;
+}
+
+// parses a comma separated list of algos
+static int32_t parse_sweep_algos_arg(const char* arg, int32_t* algos, int32_t* len) {
+    char buffer[1024];
+
+    if (strlen(arg) >= sizeof(buffer)) {
+        fprintf(stderr, "invalid sweep algos provided\n");
+
+        return 1;
+    }
+
+    strcpy(buffer, arg);
+
+    *len = 0;
+
+    for (char* item = strtok(buffer, ","); item != NULL; item = strtok(NULL, ",")) {
+        if (*len == SWEEP_MAX_LEN) {
+            fprintf(stderr, "invalid sweep algos provided\n");
+
+            return 1;
+        }
+
+        if (args_parse_algo(item, &algos[*len]) != 0) {
+            return 1;
+        }
+
+        *len += 1;
+    }
+
+    if (*len == 0) {
+        fprintf(stderr, "invalid sweep algos provided\n");
+
+        return 1;
+    }
+
+    return 0;
+}
+
+static int32_t parse_precision_arg(const char* arg, int32_t* precision) {
+    if (strncmp(arg, "double", 7) == 0) {
+        *precision = PRECISION_DOUBLE;
+    } else if (strncmp(arg, "float", 6) == 0) {
+        *precision = PRECISION_FLOAT;
+    } else if (strncmp(arg, "mixed", 6) == 0) {
+        *precision = PRECISION_MIXED;
+    } else {
+        fprintf(stderr, "invalid precision provided\n");
+
+        return 1;
+    }
+
+    return 0;
+}
+
+static int32_t parse_reduction_arg(const char* arg, int32_t* reduction) {
+    if (strncmp(arg, "thread", 7) == 0) {
+        *reduction = REDUCTION_THREAD;
+    } else if (strncmp(arg, "pairwise", 9) == 0) {
+        *reduction = REDUCTION_PAIRWISE;
+    } else if (strncmp(arg, "kahan", 6) == 0) {
+        *reduction = REDUCTION_KAHAN;
+    } else {
+        fprintf(stderr, "invalid reduction provided\n");
+
+        return 1;
+    }
+
+    return 0;
+}
+
+// parses "kind" or "kind,chunk"
+static int32_t parse_schedule_arg(const char* arg, int32_t* schedule, int32_t* chunk) {
+    const char* comma = strchr(arg, ',');
+    size_t kind_len = comma != NULL ? (size_t)(comma - arg) : strlen(arg);
+
+    if (kind_len == 6 && strncmp(arg, "static", 6) == 0) {
+        *schedule = SCHEDULE_STATIC;
+    } else if (kind_len == 7 && strncmp(arg, "dynamic", 7) == 0) {
+        *schedule = SCHEDULE_DYNAMIC;
+    } else if (kind_len == 6 && strncmp(arg, "guided", 6) == 0) {
+        *schedule = SCHEDULE_GUIDED;
+    } else {
+        fprintf(stderr, "invalid schedule provided\n");
+
+        return 1;
+    }
+
+    if (comma != NULL) {
+        int64_t parsed = 0;
+
+        if (args_parse_l(comma + 1, &parsed) != 0 || parsed < 1 || parsed > INT32_MAX / 2) {
+            fprintf(stderr, "invalid schedule chunk provided\n");
+
+            return 1;
+        }
+
+        *chunk = parsed;
+    }
+
+    return 0;
+}
+
+static int32_t parse_bind_arg(const char* arg, int32_t* bind) {
+    if (strncmp(arg, "none", 5) == 0) {
+        *bind = BIND_NONE;
+    } else if (strncmp(arg, "close", 6) == 0) {
+        *bind = BIND_CLOSE;
+    } else if (strncmp(arg, "spread", 7) == 0) {
+        *bind = BIND_SPREAD;
+    } else {
+        fprintf(stderr, "invalid bind provided\n");
+
+        return 1;
+    }
+
+    return 0;
+}
+
+static int32_t parse_sample_rate_arg(const char* arg, double* sample_rate) {
+    char* endptr;
+    double parsed = strtod(arg, &endptr);
+
+    if (endptr == arg || *endptr != '\0' || !(parsed > 0.0)) {
+        fprintf(stderr, "invalid sample rate provided\n");
+
+        return 1;
+    }
+
+    *sample_rate = parsed;
+
+    return 0;
+}
+
+static int32_t parse_compress_tolerance_arg(const char* arg, double* tolerance) {
     char* endptr;
-    *value = strtol(str, &endptr, 10);
+    double parsed = strtod(arg, &endptr);
+
+    if (endptr == arg || *endptr != '\0' || !(parsed >= 0.0)) {
+        fprintf(stderr, "invalid compress tolerance provided\n");
+
+        return 1;
+    }
+
+    *tolerance = parsed;
+
+    return 0;
+}
+
+int32_t args_parse_l(const char* str, int64_t* value) {
+    char* endptr;
+
+    errno = 0;
+    *value = strtoll(str, &endptr, 10);
 
     if (*endptr != '\0') {
         return -1;
     }
 
-    if ((*value == LONG_MAX && errno == ERANGE) || errno == EINVAL) {
+    if (errno == ERANGE || errno == EINVAL) {
         return -1;
     }
 
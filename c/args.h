@@ -8,7 +8,62 @@ enum ALGO {
     MID_RIEMANN = 1,
     RIGHT_RIEMANN = 2,
     TRAPEZOIDAL = 3,
-    SIMPSONS = 4
+    SIMPSONS = 4,
+    EXACT = 5
+};
+
+// instruction sets that the kernels can be compiled for
+enum ISA {
+    ISA_AUTO = -1,
+    ISA_SCALAR = 0,
+    ISA_AVX2 = 1,
+    ISA_AVX512 = 2,
+    ISA_NEON = 3
+};
+
+// formats for machine readable output
+enum FORMAT {
+    FORMAT_CSV = 0,
+    FORMAT_JSON = 1
+};
+
+// formats for trajectory output
+enum TRAJECTORY_FORMAT {
+    TRAJECTORY_BINARY = 0,
+    TRAJECTORY_CSV = 1
+};
+
+// how the per block results of a parallel simulation are combined. thread
+// combines one block per thread so the result depends on the number of
+// threads. pairwise and kahan split the table into blocks of a fixed size so
+// the result is the same for any number of threads.
+enum REDUCTION {
+    REDUCTION_THREAD = 0,
+    REDUCTION_PAIRWISE = 1,
+    REDUCTION_KAHAN = 2
+};
+
+// the schedule used for the loops over blocks of the table. default keeps one
+// contiguous block per thread where the runners allow it
+enum SCHEDULE {
+    SCHEDULE_DEFAULT = 0,
+    SCHEDULE_STATIC = 1,
+    SCHEDULE_DYNAMIC = 2,
+    SCHEDULE_GUIDED = 3
+};
+
+// how the threads of the runners are pinned to cpus
+enum BIND {
+    BIND_NONE = 0,
+    BIND_CLOSE = 1,
+    BIND_SPREAD = 2
+};
+
+// precisions that the profile can be stored and simulated in
+enum PRECISION {
+    PRECISION_DOUBLE = 0,
+    PRECISION_FLOAT = 1,
+    PRECISION_MIXED = 2
 };
 
 struct sim_args {
@@ -16,22 +71,71 @@ struct sim_args {
     int32_t algo;
     int32_t step;
     int32_t iterations;
+    int32_t isa;
+    int32_t fused;
+    int32_t reduction;
+    int32_t schedule;
+    // intervals per block for the block loops, 0 uses the default
+    int32_t chunk;
+    int32_t bind;
+    // keeps a single parallel region alive across all of the iterations
+    int32_t persistent;
+    // per phase timings, also counting cycles, written to profile_path in
+    // profile_format when it is set
+    int32_t profile;
+    int32_t cycles;
+    // also reads the hardware counters around each phase
+    int32_t perf;
+    const char* profile_path;
+    int32_t profile_format;
 };
 
+// the default error allowed when fitting linear runs to a profile
+#define COMPRESS_DEFAULT_TOLERANCE 1e-9
+
+// the most algos or steps a sweep accepts
+#define SWEEP_MAX_LEN 32
+
+// the default memory the server keeps cached trajectories in
+#define SERVER_DEFAULT_CACHE_MB 256
+
 struct app_args {
     char* file_path;
+    char* convert_path;
+    char* batch_path;
+    char* trajectory_path;
+    char* fleet_path;
+    char* serve_path;
+    char* index_out_path;
+    char* index_path;
+    // the memory the server keeps cached trajectories in
+    int32_t cache_mb;
+    int32_t format;
+    int32_t trajectory_format;
+    int32_t precision;
+    int32_t compress;
+    double compress_tolerance;
+    // runs the simulation on the default offload device
+    int32_t offload;
+    // integrates a csv profile while it is still being read
+    int32_t stream;
+    // the random edits made by --check-incremental. zero means no check
+    int32_t check_edits;
+    double sample_rate;
+    // the combinations run by a sweep. no steps means no sweep
+    int32_t sweep_steps[SWEEP_MAX_LEN];
+    int32_t sweep_steps_len;
+    int32_t sweep_algos[SWEEP_MAX_LEN];
+    int32_t sweep_algos_len;
     struct sim_args sim;
 };
 
-void print_help();
-void print_full_help();
+void sim_args_init(struct sim_args* self);
 
-int32_t parse_threads_arg(const char* arg, int32_t* threads);
-int32_t parse_algo_arg(const char* arg, int32_t* algo);
-int32_t parse_step_arg(const char* arg, int32_t* step);
-int32_t parse_iterations_arg(const char* arg, int32_t* iterations);
+int32_t args_parse_algo(const char* arg, int32_t* algo);
+int32_t args_parse_step(const char* arg, int32_t* step);
 
-int32_t parse_l(const char* str, int64_t* value);
+int32_t args_parse_l(const char* str, int64_t* value);
 
 int32_t app_args_init(struct app_args* self, int argc, char** argv);
 
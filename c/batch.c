@@ -0,0 +1,380 @@
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <omp.h>
+
+#include "args.h"
+#include "batch.h"
+#include "context.h"
+#include "kernels.h"
+#include "profile.h"
+#include "ts.h"
+
+void batch_init(struct batch* self) {
+    self->jobs = NULL;
+    self->len = 0;
+    self->capacity = 0;
+}
+
+void batch_free(struct batch* self) {
+    for (int32_t index = 0; index < self->len; index += 1) {
+        free(self->jobs[index].file_path);
+    }
+
+    free(self->jobs);
+
+    batch_init(self);
+}
+
+static char* trim(char* str) {
+    while (*str == ' ' || *str == '\t') {
+        str += 1;
+    }
+
+    char* end = str + strlen(str);
+
+    while (end > str && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\n' || end[-1] == '\r')) {
+        end -= 1;
+    }
+
+    *end = '\0';
+
+    return str;
+}
+
+// reads a manifest where each line is a job in the form "path[,algo[,step]]".
+// empty lines and lines starting with # are skipped. the algo and step default
+// to the values given on the command line. a line that does not fit in the
+// line buffer is rejected instead of being read as more than one job.
+int32_t batch_load_manifest(struct batch* self, const char* manifest_path, struct sim_args* defaults) {
+    FILE* file = fopen(manifest_path, "r");
+
+    if (file == NULL) {
+        fprintf(stderr, "failed to open batch manifest \"%s\". %s\n", manifest_path, strerror(errno));
+
+        return 1;
+    }
+
+    char line[4096];
+    int64_t line_num = 0;
+
+    while (fgets(line, sizeof(line), file) != NULL) {
+        line_num += 1;
+
+        // only the last line of the file may end without a newline
+        if (strchr(line, '\n') == NULL) {
+            int next = fgetc(file);
+
+            if (next != EOF) {
+                fprintf(
+                    stderr,
+                    "batch manifest line is longer than %d bytes. %ld\n",
+                    (int)sizeof(line) - 2,
+                    (long)line_num
+                );
+
+                fclose(file);
+
+                return 1;
+            }
+        }
+
+        char* entry = trim(line);
+
+        if (*entry == '\0' || *entry == '#') {
+            continue;
+        }
+
+        char* path = trim(strsep(&entry, ","));
+        char* algo = entry != NULL ? trim(strsep(&entry, ",")) : NULL;
+        char* step = entry != NULL ? trim(entry) : NULL;
+
+        struct batch_job job;
+        job.index = self->len;
+        job.algo = defaults->algo;
+        job.step = defaults->step;
+        job.len = 0;
+        job.velocity = 0.0;
+        job.position = 0.0;
+        job.elapsed.tv_sec = 0;
+        job.elapsed.tv_nsec = 0;
+        job.failed = 0;
+
+        if (
+            *path == '\0' ||
+            (algo != NULL && *algo != '\0' && args_parse_algo(algo, &job.algo) != 0) ||
+            (step != NULL && *step != '\0' && args_parse_step(step, &job.step) != 0)
+        ) {
+            fprintf(stderr, "invalid batch manifest entry. %ld\n", (long)line_num);
+
+            fclose(file);
+
+            return 1;
+        }
+
+        if (self->len == self->capacity) {
+            int32_t capacity = self->capacity == 0 ? 64 : self->capacity * 2;
+            struct batch_job* grown = (struct batch_job*)realloc(
+                self->jobs,
+                (size_t)capacity * sizeof(struct batch_job)
+            );
+
+            if (grown == NULL) {
+                fprintf(stderr, "failed growing batch jobs. %s\n", strerror(errno));
+
+                fclose(file);
+
+                return 1;
+            }
+
+            self->jobs = grown;
+            self->capacity = capacity;
+        }
+
+        job.file_path = strdup(path);
+
+        if (job.file_path == NULL) {
+            fprintf(stderr, "failed allocating batch job path. %s\n", strerror(errno));
+
+            fclose(file);
+
+            return 1;
+        }
+
+        self->jobs[self->len] = job;
+        self->len += 1;
+    }
+
+    fclose(file);
+
+    return 0;
+}
+
+void batch_job_run(struct batch_job* job, struct sim_context* context, struct lut_info* lut) {
+    struct timespec start;
+    struct timespec end;
+    struct sim_result result;
+
+    sim_context_configure(context, job->algo, job->step);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    if (sim_context_run(context, lut, &result) != 0) {
+        job->failed = 1;
+
+        return;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    timespec_diff(&start, &end, &job->elapsed);
+
+    job->len = lut->len;
+    job->velocity = result.velocity;
+    job->position = result.position;
+}
+
+// prints the string with the characters that json requires to be escaped
+void batch_print_json_string(const char* str) {
+    putchar('"');
+
+    for (const char* iter = str; *iter != '\0'; iter += 1) {
+        if (*iter == '"' || *iter == '\\') {
+            putchar('\\');
+            putchar(*iter);
+        } else if ((unsigned char)*iter < 0x20) {
+            printf("\\u%04x", (unsigned char)*iter);
+        } else {
+            putchar(*iter);
+        }
+    }
+
+    putchar('"');
+}
+
+// prints the string as a csv field, quoted with any quotes doubled when it
+// contains a separator, a quote or a line break
+void batch_print_csv_string(const char* str) {
+    if (strpbrk(str, ",\"\r\n") == NULL) {
+        fputs(str, stdout);
+
+        return;
+    }
+
+    putchar('"');
+
+    for (const char* iter = str; *iter != '\0'; iter += 1) {
+        if (*iter == '"') {
+            putchar('"');
+        }
+
+        putchar(*iter);
+    }
+
+    putchar('"');
+}
+
+void batch_job_print(struct batch_job* job, int32_t format) {
+    if (format == FORMAT_JSON) {
+        printf("{\"index\":%d,\"path\":", job->index);
+        batch_print_json_string(job->file_path);
+        printf(
+            ",\"algo\":\"%s\",\"step\":%d,\"len\":%d,"
+            "\"velocity\":%.15lf,\"position\":%.15lf,\"seconds\":%ld.%.9ld,\"ok\":%s}\n",
+            get_lut_kernel(job->algo)->name,
+            job->step,
+            job->len,
+            job->velocity,
+            job->position,
+            job->elapsed.tv_sec,
+            job->elapsed.tv_nsec,
+            job->failed ? "false" : "true"
+        );
+    } else {
+        printf("%d,", job->index);
+        batch_print_csv_string(job->file_path);
+        printf(
+            ",%s,%d,%d,%.15lf,%.15lf,%ld.%.9ld,%s\n",
+            get_lut_kernel(job->algo)->name,
+            job->step,
+            job->len,
+            job->velocity,
+            job->position,
+            job->elapsed.tv_sec,
+            job->elapsed.tv_nsec,
+            job->failed ? "failed" : "ok"
+        );
+    }
+}
+
+// runs every job in the batch inside of a single parallel region. each
+// distinct profile is loaded once by a task which then creates a task for
+// every job that uses it, so idle threads pick up work from any profile
+// instead of only splitting the intervals of one. results are written as
+// each job finishes.
+int32_t batch_run(struct batch* self, struct sim_args* args, int32_t format) {
+    int32_t failed = 0;
+
+    // one context per thread that is reused by every job the thread runs.
+    // each job runs on a single thread with the fused pass so the contexts
+    // do not need a velocity table.
+    struct sim_args job_args = *args;
+    job_args.threads = 1;
+    job_args.fused = 1;
+
+    struct sim_context* contexts = (struct sim_context*)malloc(
+        (size_t)args->threads * sizeof(struct sim_context)
+    );
+
+    if (contexts == NULL) {
+        fprintf(stderr, "failed allocating batch contexts. %s\n", strerror(errno));
+
+        return 1;
+    }
+
+    for (int32_t index = 0; index < args->threads; index += 1) {
+        if (sim_context_init(&contexts[index], &job_args, 0) != 0) {
+            for (int32_t prev = 0; prev <= index; prev += 1) {
+                sim_context_free(&contexts[prev]);
+            }
+
+            free(contexts);
+
+            return 1;
+        }
+    }
+
+    if (format == FORMAT_CSV) {
+        printf("index,path,algo,step,len,velocity,position,seconds,status\n");
+    }
+
+#pragma omp parallel num_threads(args->threads)
+#pragma omp single
+    for (int32_t index = 0; index < self->len; index += 1) {
+        int32_t first_use = 1;
+
+        for (int32_t prev = 0; prev < index; prev += 1) {
+            if (strcmp(self->jobs[prev].file_path, self->jobs[index].file_path) == 0) {
+                first_use = 0;
+
+                break;
+            }
+        }
+
+        if (!first_use) {
+            continue;
+        }
+
+#pragma omp task firstprivate(index) shared(failed)
+        {
+            const char* file_path = self->jobs[index].file_path;
+            struct profile profile;
+            profile_init(&profile);
+
+            int32_t loaded = profile_load(file_path, &profile) == 0;
+
+            if (loaded && profile.lut.len < 2) {
+                fprintf(stderr, "acceleration profile must contain at least 2 entries. %s\n", file_path);
+
+                profile_free(&profile);
+
+                loaded = 0;
+            }
+
+            for (int32_t job_index = index; job_index < self->len; job_index += 1) {
+                struct batch_job* job = &self->jobs[job_index];
+
+                if (strcmp(job->file_path, file_path) != 0) {
+                    continue;
+                }
+
+                if (!loaded) {
+                    job->failed = 1;
+
+#pragma omp critical(batch_output)
+                    {
+                        failed = 1;
+
+                        batch_job_print(job, format);
+                    }
+
+                    continue;
+                }
+
+#pragma omp task firstprivate(job) shared(profile, format, failed)
+                {
+                    batch_job_run(job, &contexts[omp_get_thread_num()], &profile.lut);
+
+#pragma omp critical(batch_output)
+                    {
+                        if (job->failed) {
+                            failed = 1;
+                        }
+
+                        batch_job_print(job, format);
+                    }
+                }
+            }
+
+            // the profile has to outlive the jobs that were created for it
+#pragma omp taskwait
+
+            if (loaded) {
+                profile_free(&profile);
+            }
+        }
+    }
+
+    fflush(stdout);
+
+    for (int32_t index = 0; index < args->threads; index += 1) {
+        sim_context_free(&contexts[index]);
+    }
+
+    free(contexts);
+
+    return failed;
+}
@@ -0,0 +1,42 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdint.h>
+#include <time.h>
+
+#include "args.h"
+#include "context.h"
+
+// a single simulation listed in a batch manifest
+struct batch_job {
+    int32_t index;
+    char* file_path;
+    int32_t algo;
+    int32_t step;
+
+    int32_t len;
+    double velocity;
+    double position;
+    struct timespec elapsed;
+    int32_t failed;
+};
+
+struct batch {
+    struct batch_job* jobs;
+    int32_t len;
+    int32_t capacity;
+};
+
+void batch_init(struct batch* self);
+void batch_free(struct batch* self);
+
+int32_t batch_load_manifest(struct batch* self, const char* manifest_path, struct sim_args* defaults);
+int32_t batch_run(struct batch* self, struct sim_args* args, int32_t format);
+
+void batch_job_run(struct batch_job* job, struct sim_context* context, struct lut_info* lut);
+void batch_job_print(struct batch_job* job, int32_t format);
+
+void batch_print_json_string(const char* str);
+void batch_print_csv_string(const char* str);
+
+#endif
@@ -0,0 +1,627 @@
+// benchmark harness that runs the c and rust engines over a matrix of table
+// sizes, algorithms, step counts and thread counts. each point of the matrix
+// runs the engine as a separate process several times and the average
+// iteration time that the engine reports for each run is one trial. a summary
+// line of every point is written as csv so the results can be compared
+// between runs of the harness.
+
+#include <errno.h>
+#include <getopt.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "args.h"
+
+#define BENCH_MAX_LIST 32
+#define BENCH_MAX_TRIALS 1024
+#define BENCH_COMMAND_LEN 4096
+
+enum ENGINE {
+    ENGINE_C = 0,
+    ENGINE_RUST = 1
+};
+
+struct bench_args {
+    const char* c_path;
+    const char* rust_path;
+    const char* out_path;
+    const char* data_dir;
+
+    int32_t sizes[BENCH_MAX_LIST];
+    int32_t sizes_len;
+    const char* algos[BENCH_MAX_LIST];
+    int32_t algos_len;
+    int32_t steps[BENCH_MAX_LIST];
+    int32_t steps_len;
+    int32_t threads[BENCH_MAX_LIST];
+    int32_t threads_len;
+
+    int32_t trials;
+    int32_t warmup;
+    int32_t iterations;
+};
+
+// what a single run of an engine reported
+struct bench_run {
+    double seconds;
+    double velocity;
+    double position;
+};
+
+struct bench_summary {
+    double mean;
+    double stddev;
+    double min;
+    double median;
+    double max;
+    double ci95;
+};
+
+static const char* ALGO_NAMES[] = {
+    "left-riemann",
+    "mid-riemann",
+    "right-riemann",
+    "trapezoidal",
+    "simpsons"
+};
+
+static void print_bench_help() {
+    printf(
+"runs the c and rust engines over a matrix of profiles and options and\n"
+"writes a csv summary of the iteration times of each\n"
+"\n"
+"Usage: bench [OPTIONS]\n"
+"\n"
+"Options:\n"
+"      --c <PATH>          the c engine [default: build/release/sim]\n"
+"      --rust <PATH>       the rust engine, skipped when it does not exist\n"
+"                          [default: ../target/release/train_sim]\n"
+"      --out <PATH>        where to write the summary [default: stdout]\n"
+"      --data <DIR>        where the synthetic profiles are generated and\n"
+"                          reused from [default: build/bench]\n"
+"      --sizes <LIST>      profile sizes [default: 1801,100000,1000000,10000000]\n"
+"      --algos <LIST>      algorithms [default: all five]\n"
+"      --steps <LIST>      step counts [default: 10,100]\n"
+"      --threads <LIST>    thread counts, the speedup column is relative to\n"
+"                          the first [default: 1,2,4]\n"
+"      --trials <N>        measured runs of each point [default: 5]\n"
+"      --warmup <N>        runs of each point that are discarded [default: 1]\n"
+"      --iterations <N>    iterations inside of each run [default: 10]\n"
+"  -h, --help              prints this help\n"
+    );
+}
+
+static int32_t parse_positive(const char* arg, int32_t* value) {
+    int64_t parsed = 0;
+
+    if (args_parse_l(arg, &parsed) != 0 || parsed < 0 || parsed > INT32_MAX) {
+        return 1;
+    }
+
+    *value = (int32_t)parsed;
+
+    return 0;
+}
+
+// parses a comma separated list of numbers that are at least 1
+static int32_t parse_int_list(const char* arg, int32_t* list, int32_t* len) {
+    char buffer[1024];
+
+    if (strlen(arg) >= sizeof(buffer)) {
+        return 1;
+    }
+
+    strcpy(buffer, arg);
+
+    *len = 0;
+
+    for (char* item = strtok(buffer, ","); item != NULL; item = strtok(NULL, ",")) {
+        if (*len == BENCH_MAX_LIST || parse_positive(item, &list[*len]) != 0 || list[*len] < 1) {
+            return 1;
+        }
+
+        *len += 1;
+    }
+
+    return *len == 0;
+}
+
+// parses a comma separated list of algorithms into the matching static names
+static int32_t parse_algo_list(const char* arg, const char** list, int32_t* len) {
+    char buffer[1024];
+
+    if (strlen(arg) >= sizeof(buffer)) {
+        return 1;
+    }
+
+    strcpy(buffer, arg);
+
+    *len = 0;
+
+    for (char* item = strtok(buffer, ","); item != NULL; item = strtok(NULL, ",")) {
+        const char* found = NULL;
+
+        for (size_t index = 0; index < sizeof(ALGO_NAMES) / sizeof(ALGO_NAMES[0]); index += 1) {
+            if (strcmp(item, ALGO_NAMES[index]) == 0) {
+                found = ALGO_NAMES[index];
+            }
+        }
+
+        if (found == NULL || *len == BENCH_MAX_LIST) {
+            return 1;
+        }
+
+        list[*len] = found;
+        *len += 1;
+    }
+
+    return *len == 0;
+}
+
+static int32_t bench_args_init(struct bench_args* self, int argc, char** argv) {
+    self->c_path = "build/release/sim";
+    self->rust_path = "../target/release/train_sim";
+    self->out_path = NULL;
+    self->data_dir = "build/bench";
+
+    const int32_t sizes[] = { 1801, 100000, 1000000, 10000000 };
+    const int32_t steps[] = { 10, 100 };
+    const int32_t threads[] = { 1, 2, 4 };
+
+    self->sizes_len = sizeof(sizes) / sizeof(sizes[0]);
+    memcpy(self->sizes, sizes, sizeof(sizes));
+    self->algos_len = sizeof(ALGO_NAMES) / sizeof(ALGO_NAMES[0]);
+    memcpy(self->algos, ALGO_NAMES, sizeof(ALGO_NAMES));
+    self->steps_len = sizeof(steps) / sizeof(steps[0]);
+    memcpy(self->steps, steps, sizeof(steps));
+    self->threads_len = sizeof(threads) / sizeof(threads[0]);
+    memcpy(self->threads, threads, sizeof(threads));
+
+    self->trials = 5;
+    self->warmup = 1;
+    self->iterations = 10;
+
+    struct option long_options[] = {
+        {"c", required_argument, 0, 0 },
+        {"rust", required_argument, 0, 0 },
+        {"out", required_argument, 0, 0 },
+        {"data", required_argument, 0, 0 },
+        {"sizes", required_argument, 0, 0 },
+        {"algos", required_argument, 0, 0 },
+        {"steps", required_argument, 0, 0 },
+        {"threads", required_argument, 0, 0 },
+        {"trials", required_argument, 0, 0 },
+        {"warmup", required_argument, 0, 0 },
+        {"iterations", required_argument, 0, 0 },
+        {"help", no_argument, 0, 0 },
+        {0, 0, 0, 0 }
+    };
+
+    while (1) {
+        int option_index = 0;
+        int c = getopt_long(argc, argv, "h", long_options, &option_index);
+        int32_t invalid = 0;
+
+        if (c == -1) {
+            break;
+        }
+
+        if (c == 'h') {
+            print_bench_help();
+
+            return 1;
+        }
+
+        if (c != 0) {
+            return 1;
+        }
+
+        switch (option_index) {
+        case 0:
+            self->c_path = optarg;
+            break;
+        case 1:
+            self->rust_path = optarg;
+            break;
+        case 2:
+            self->out_path = optarg;
+            break;
+        case 3:
+            self->data_dir = optarg;
+            break;
+        case 4:
+            invalid = parse_int_list(optarg, self->sizes, &self->sizes_len) != 0 ||
+                self->sizes[0] < 2;
+            break;
+        case 5:
+            invalid = parse_algo_list(optarg, self->algos, &self->algos_len);
+            break;
+        case 6:
+            invalid = parse_int_list(optarg, self->steps, &self->steps_len);
+            break;
+        case 7:
+            invalid = parse_int_list(optarg, self->threads, &self->threads_len);
+            break;
+        case 8:
+            invalid = parse_positive(optarg, &self->trials) != 0 ||
+                self->trials < 1 ||
+                self->trials > BENCH_MAX_TRIALS;
+            break;
+        case 9:
+            invalid = parse_positive(optarg, &self->warmup);
+            break;
+        case 10:
+            invalid = parse_positive(optarg, &self->iterations) != 0 || self->iterations < 1;
+            break;
+        case 11:
+            print_bench_help();
+
+            return 1;
+        }
+
+        if (invalid) {
+            fprintf(stderr, "invalid value for --%s. %s\n", long_options[option_index].name, optarg);
+
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static int32_t file_exists(const char* path) {
+    struct stat info;
+
+    return stat(path, &info) == 0;
+}
+
+// writes a csv profile of the given size that the engines are able to load.
+// the acceleration is a bounded random walk from a fixed seed so the same
+// size always produces the same profile.
+static int32_t generate_profile(const char* path, int32_t size) {
+    FILE* file = fopen(path, "w");
+
+    if (file == NULL) {
+        fprintf(stderr, "failed to create synthetic profile \"%s\". %s\n", path, strerror(errno));
+
+        return 1;
+    }
+
+    uint64_t state = 0x9e3779b97f4a7c15ull ^ (uint64_t)size;
+    double accel = 0.0;
+
+    for (int32_t index = 0; index < size; index += 1) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+
+        accel += ((double)(state >> 11) / 9007199254740992.0 - 0.5) * 0.1;
+
+        if (accel > 2.0) {
+            accel = 2.0;
+        } else if (accel < -2.0) {
+            accel = -2.0;
+        }
+
+        fprintf(file, "%.17g\n", accel);
+    }
+
+    if (fclose(file) != 0) {
+        fprintf(stderr, "failed writing synthetic profile \"%s\". %s\n", path, strerror(errno));
+
+        return 1;
+    }
+
+    return 0;
+}
+
+// returns the value after the given label at the start of a line
+static int32_t parse_labeled(const char* line, const char* label, double* value) {
+    size_t len = strlen(label);
+
+    if (strncmp(line, label, len) != 0) {
+        return 0;
+    }
+
+    char* end = NULL;
+    double parsed = strtod(line + len, &end);
+
+    if (end == line + len) {
+        return 0;
+    }
+
+    *value = parsed;
+
+    return 1;
+}
+
+// runs the engine once and collects the average iteration time and the final
+// state from its output. both engines print "avg:" for more than one
+// iteration and "total:" for a single one.
+static int32_t run_engine(
+    int32_t engine,
+    const char* engine_path,
+    const char* profile_path,
+    const char* algo,
+    int32_t step,
+    int32_t threads,
+    int32_t iterations,
+    struct bench_run* run
+) {
+    char command[BENCH_COMMAND_LEN];
+    int written = 0;
+
+    if (engine == ENGINE_C) {
+        written = snprintf(
+            command,
+            sizeof(command),
+            "'%s' -t %d -a %s -s %d -i %d '%s'",
+            engine_path,
+            threads,
+            algo,
+            step,
+            iterations,
+            profile_path
+        );
+    } else {
+        written = snprintf(
+            command,
+            sizeof(command),
+            "'%s' -t %d -a %s -s %d -i %d csv '%s'",
+            engine_path,
+            threads,
+            algo,
+            step,
+            iterations,
+            profile_path
+        );
+    }
+
+    if (written < 0 || (size_t)written >= sizeof(command)) {
+        fprintf(stderr, "engine command is too long\n");
+
+        return 1;
+    }
+
+    FILE* output = popen(command, "r");
+
+    if (output == NULL) {
+        fprintf(stderr, "failed to run engine \"%s\". %s\n", engine_path, strerror(errno));
+
+        return 1;
+    }
+
+    char line[1024];
+    int32_t found_time = 0;
+    int32_t found_vel = 0;
+    int32_t found_pos = 0;
+
+    while (fgets(line, sizeof(line), output) != NULL) {
+        // the periodic iteration logs print the same labels so the last
+        // value seen is the final one
+        found_time |= parse_labeled(line, "avg: ", &run->seconds);
+        found_time |= parse_labeled(line, "total: ", &run->seconds);
+        found_vel |= parse_labeled(line, "velocity: ", &run->velocity);
+        found_vel |= parse_labeled(line, "final velocity: ", &run->velocity);
+        found_pos |= parse_labeled(line, "position: ", &run->position);
+        found_pos |= parse_labeled(line, "final position: ", &run->position);
+    }
+
+    int status = pclose(output);
+
+    if (status != 0 || !found_time || !found_vel || !found_pos) {
+        fprintf(stderr, "engine run failed or printed no results. %s\n", command);
+
+        return 1;
+    }
+
+    return 0;
+}
+
+static int compare_doubles(const void* l, const void* r) {
+    double lhs = *(const double*)l;
+    double rhs = *(const double*)r;
+
+    return (lhs > rhs) - (lhs < rhs);
+}
+
+// two sided 95% critical values of the t distribution for 1 to 30 degrees of
+// freedom. anything past that uses the normal value.
+static double t_critical(int32_t freedom) {
+    static const double table[] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+    };
+
+    if (freedom < 1) {
+        return 0.0;
+    }
+
+    if (freedom <= 30) {
+        return table[freedom - 1];
+    }
+
+    return 1.960;
+}
+
+// sorts the samples in place
+static void summarize(double* samples, int32_t count, struct bench_summary* summary) {
+    double total = 0.0;
+
+    qsort(samples, (size_t)count, sizeof(double), compare_doubles);
+
+    for (int32_t index = 0; index < count; index += 1) {
+        total += samples[index];
+    }
+
+    summary->mean = total / (double)count;
+    summary->min = samples[0];
+    summary->max = samples[count - 1];
+    summary->median = count % 2 == 1
+        ? samples[count / 2]
+        : (samples[count / 2 - 1] + samples[count / 2]) / 2.0;
+
+    double squares = 0.0;
+
+    for (int32_t index = 0; index < count; index += 1) {
+        double diff = samples[index] - summary->mean;
+
+        squares += diff * diff;
+    }
+
+    summary->stddev = count > 1 ? sqrt(squares / (double)(count - 1)) : 0.0;
+    summary->ci95 = t_critical(count - 1) * summary->stddev / sqrt((double)count);
+}
+
+// runs every point of the matrix for one engine over one profile
+static int32_t bench_engine(
+    struct bench_args* args,
+    FILE* out,
+    int32_t engine,
+    const char* engine_path,
+    const char* profile_path,
+    int32_t size
+) {
+    const char* engine_name = engine == ENGINE_C ? "c" : "rust";
+    double samples[BENCH_MAX_TRIALS];
+
+    for (int32_t algo = 0; algo < args->algos_len; algo += 1) {
+        for (int32_t step = 0; step < args->steps_len; step += 1) {
+            double baseline = 0.0;
+
+            for (int32_t thread = 0; thread < args->threads_len; thread += 1) {
+                struct bench_run run;
+                int32_t failed = 0;
+
+                for (int32_t trial = 0; trial < args->warmup + args->trials && !failed; trial += 1) {
+                    failed = run_engine(
+                        engine,
+                        engine_path,
+                        profile_path,
+                        args->algos[algo],
+                        args->steps[step],
+                        args->threads[thread],
+                        args->iterations,
+                        &run
+                    );
+
+                    if (!failed && trial >= args->warmup) {
+                        samples[trial - args->warmup] = run.seconds;
+                    }
+                }
+
+                if (failed) {
+                    return 1;
+                }
+
+                struct bench_summary summary;
+
+                summarize(samples, args->trials, &summary);
+
+                if (thread == 0) {
+                    baseline = summary.mean;
+                }
+
+                fprintf(
+                    out,
+                    "%s,%d,%s,%d,%d,%d,%d,%.9f,%.9f,%.9f,%.9f,%.9f,%.9f,%.3f,%.15g,%.15g\n",
+                    engine_name,
+                    size,
+                    args->algos[algo],
+                    args->steps[step],
+                    args->threads[thread],
+                    args->iterations,
+                    args->trials,
+                    summary.mean,
+                    summary.stddev,
+                    summary.min,
+                    summary.median,
+                    summary.max,
+                    summary.ci95,
+                    summary.mean > 0.0 ? baseline / summary.mean : 0.0,
+                    run.velocity,
+                    run.position
+                );
+                fflush(out);
+            }
+        }
+    }
+
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    struct bench_args args;
+
+    if (bench_args_init(&args, argc, argv) != 0) {
+        return 1;
+    }
+
+    if (!file_exists(args.c_path)) {
+        fprintf(stderr, "c engine not found \"%s\"\n", args.c_path);
+
+        return 1;
+    }
+
+    int32_t with_rust = file_exists(args.rust_path);
+
+    if (!with_rust) {
+        fprintf(stderr, "rust engine not found \"%s\", only the c engine is run\n", args.rust_path);
+    }
+
+    if (mkdir(args.data_dir, 0755) != 0 && errno != EEXIST) {
+        fprintf(stderr, "failed to create data directory \"%s\". %s\n", args.data_dir, strerror(errno));
+
+        return 1;
+    }
+
+    FILE* out = stdout;
+
+    if (args.out_path != NULL) {
+        out = fopen(args.out_path, "w");
+
+        if (out == NULL) {
+            fprintf(stderr, "failed to create output \"%s\". %s\n", args.out_path, strerror(errno));
+
+            return 1;
+        }
+    }
+
+    fprintf(
+        out,
+        "engine,size,algo,step,threads,iterations,trials,mean,stddev,min,median,max,ci95,speedup,velocity,position\n"
+    );
+
+    int32_t result = 0;
+
+    for (int32_t size = 0; size < args.sizes_len && result == 0; size += 1) {
+        char profile_path[BENCH_COMMAND_LEN / 2];
+
+        snprintf(profile_path, sizeof(profile_path), "%s/bench_%d.csv", args.data_dir, args.sizes[size]);
+
+        if (!file_exists(profile_path) && generate_profile(profile_path, args.sizes[size]) != 0) {
+            result = 1;
+
+            break;
+        }
+
+        result = bench_engine(&args, out, ENGINE_C, args.c_path, profile_path, args.sizes[size]);
+
+        if (result == 0 && with_rust) {
+            result = bench_engine(&args, out, ENGINE_RUST, args.rust_path, profile_path, args.sizes[size]);
+        }
+    }
+
+    if (out != stdout && fclose(out) != 0) {
+        fprintf(stderr, "failed writing output \"%s\". %s\n", args.out_path, strerror(errno));
+
+        result = 1;
+    }
+
+    return result;
+}
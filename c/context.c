@@ -0,0 +1,1033 @@
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <omp.h>
+
+#include "arena.h"
+#include "args.h"
+#include "context.h"
+#include "kernels.h"
+#include "parallel.h"
+#include "trajectory.h"
+#include "ts.h"
+
+// the number of fixed size blocks the intervals of a table of the given length
+// are split into by chunk_range
+static size_t reduction_chunks(int32_t len, int32_t block_len) {
+    return ((size_t)len + (size_t)block_len - 1) / (size_t)block_len;
+}
+
+// the intervals [first, last) of the given fixed size block of the table. the
+// blocks are split at multiples of block_len so with the block length rounded
+// to a cache line every block starts on a line of the velocity table. the
+// first block is one interval short since the intervals start at 1
+static inline void chunk_range(int32_t len, int32_t block_len, int32_t chunk, int32_t* first, int32_t* last) {
+    int64_t end = (int64_t)(chunk + 1) * block_len;
+
+    *first = chunk == 0 ? 1 : chunk * block_len;
+    *last = end < len ? (int32_t)end : len;
+}
+
+// touches the velocity table from the threads that will write to it so each
+// page is placed on the numa node of the thread that uses it instead of the
+// node of the thread that allocated it. the split matches
+// parallel_thread_range in the runners and the static schedule of the block
+// loops.
+static void sim_context_first_touch(struct sim_context* self, int32_t capacity) {
+    double* values = self->vel_lut.lut;
+
+    if (values == NULL) {
+        return;
+    }
+
+#pragma omp parallel num_threads(self->args.threads)
+    {
+        int32_t first;
+        int32_t last;
+
+        parallel_thread_range(0, capacity, &first, &last);
+
+        for (int32_t index = first; index < last; index += 1) {
+            values[index] = 0.0;
+        }
+    }
+}
+
+// lays out the scratch buffers in the arena for tables of up to the given
+// length. the velocity table is skipped for the fused pass since it does not
+// need one and the blocks of the deterministic reductions are only allocated
+// when one is used.
+static int32_t sim_context_carve(struct sim_context* self, int32_t capacity) {
+    size_t threads = (size_t)self->args.threads;
+    size_t vel_len = self->args.fused ? 0 : (size_t)capacity;
+    size_t chunks = self->args.reduction != REDUCTION_THREAD
+        ? reduction_chunks(capacity, self->block_len)
+        : 0;
+    size_t size = threads * THREAD_PAD * sizeof(double) +
+        threads * sizeof(struct fused_block) +
+        chunks * sizeof(struct fused_block) +
+        chunks * sizeof(double) +
+        vel_len * sizeof(double) +
+        5 * ARENA_ALIGN;
+
+    if (arena_reserve(&self->arena, size) != 0) {
+        return 1;
+    }
+
+    arena_reset(&self->arena);
+
+    self->partials = (double*)arena_alloc(
+        &self->arena,
+        threads * THREAD_PAD * sizeof(double),
+        ARENA_ALIGN
+    );
+    self->blocks = (struct fused_block*)arena_alloc(
+        &self->arena,
+        threads * sizeof(struct fused_block),
+        ARENA_ALIGN
+    );
+    self->chunks = chunks > 0
+        ? (struct fused_block*)arena_alloc(&self->arena, chunks * sizeof(struct fused_block), ARENA_ALIGN)
+        : NULL;
+    self->chunk_sums = chunks > 0
+        ? (double*)arena_alloc(&self->arena, chunks * sizeof(double), ARENA_ALIGN)
+        : NULL;
+    self->vel_lut.len = 0;
+    self->vel_lut.lut = vel_len > 0
+        ? (double*)arena_alloc(&self->arena, vel_len * sizeof(double), ARENA_ALIGN)
+        : NULL;
+    self->capacity = capacity;
+
+    sim_context_first_touch(self, capacity);
+
+    return 0;
+}
+
+int32_t sim_context_init(struct sim_context* self, struct sim_args* args, int32_t capacity) {
+    self->args = *args;
+    self->kernel = get_lut_kernel(args->algo);
+    self->capacity = 0;
+    self->vel_lut.len = 0;
+    self->vel_lut.lut = NULL;
+    self->partials = NULL;
+    self->blocks = NULL;
+    self->chunks = NULL;
+    self->chunk_sums = NULL;
+    // rounded up to a whole number of cache lines of the velocity table so
+    // together with the split of chunk_range no two blocks share a line
+    self->block_len = args->chunk > 0
+        ? (args->chunk + THREAD_PAD - 1) / THREAD_PAD * THREAD_PAD
+        : REDUCTION_BLOCK_LEN;
+
+    arena_init(&self->arena);
+    timing_init(&self->time_data);
+    log_timer_init(&self->log_time);
+    // before any parallel region so the counters are inherited by the
+    // OpenMP workers
+    profiler_init(&self->profiler, args->profile, args->cycles, args->perf);
+
+    if (args->bind != BIND_NONE && parallel_bind_threads(args->threads, args->bind) != 0) {
+        return 1;
+    }
+
+    if (sim_context_carve(self, capacity) != 0) {
+        return 1;
+    }
+
+    return 0;
+}
+
+void sim_context_free(struct sim_context* self) {
+    arena_free(&self->arena);
+    profiler_free(&self->profiler);
+
+    self->capacity = 0;
+    self->vel_lut.lut = NULL;
+    self->partials = NULL;
+    self->blocks = NULL;
+    self->chunks = NULL;
+    self->chunk_sums = NULL;
+}
+
+// grows the scratch buffers if they are not able to hold a table of the given
+// length
+int32_t sim_context_reserve(struct sim_context* self, int32_t capacity) {
+    if (capacity <= self->capacity) {
+        return 0;
+    }
+
+    return sim_context_carve(self, capacity);
+}
+
+// changes the algorithm and step of the context without touching the scratch
+// buffers
+void sim_context_configure(struct sim_context* self, int32_t algo, int32_t step) {
+    self->args.algo = algo;
+    self->args.step = step;
+    self->kernel = get_lut_kernel(algo);
+}
+
+static void set_omp_schedule(int32_t schedule) {
+    switch (schedule) {
+    case SCHEDULE_DYNAMIC:
+        omp_set_schedule(omp_sched_dynamic, 1);
+        break;
+    case SCHEDULE_GUIDED:
+        omp_set_schedule(omp_sched_guided, 1);
+        break;
+    default:
+        omp_set_schedule(omp_sched_static, 0);
+        break;
+    }
+}
+
+static void run_serial(struct sim_context* self, struct lut_info* lut, struct sim_result* result) {
+    const struct lut_kernel* kernel = self->kernel;
+    int32_t step = self->args.step;
+
+    if (self->args.fused) {
+        struct fused_state state;
+        state.vel = 0.0;
+        state.pos = 0.0;
+
+        kernel->fused(lut, 1, lut->len, step, &state);
+
+        profiler_lap(&self->profiler, PHASE_FUSED);
+
+        result->velocity = state.vel;
+        result->position = state.pos;
+    } else {
+        struct lut_info* vel_lut = &self->vel_lut;
+
+        result->velocity = kernel->cumulate(lut, 1, lut->len, step, 0.0, vel_lut->lut);
+
+        profiler_lap(&self->profiler, PHASE_VELOCITY);
+
+        result->position = kernel->position(lut, vel_lut, 1, vel_lut->len, step);
+
+        profiler_lap(&self->profiler, PHASE_POSITION);
+    }
+}
+
+// the position gained over a single interval from a constant velocity of 1.
+// starting a fused pass at velocity v instead of zero adds v * weight to the
+// position of every interval after it.
+static double fused_weight(const struct lut_kernel* kernel, int32_t step) {
+    struct lut_interval_coeffs coeffs;
+
+    lut_interval_coeffs(kernel, step, &coeffs);
+
+    return coeffs.q0;
+}
+
+// each thread runs the fused pass over its own block of [begin, end) starting
+// from zero. returns the number of blocks that were run
+static int32_t fused_blocks_openmp(struct sim_context* self, struct lut_info* lut, int32_t begin, int32_t end) {
+    const struct lut_kernel* kernel = self->kernel;
+    struct fused_block* blocks = self->blocks;
+    int32_t step = self->args.step;
+    int32_t threads = 1;
+
+#pragma omp parallel num_threads(self->args.threads)
+    {
+        int32_t thread = omp_get_thread_num();
+        int32_t first;
+        int32_t last;
+
+        parallel_thread_range(begin, end, &first, &last);
+
+        blocks[thread].state.vel = 0.0;
+        blocks[thread].state.pos = 0.0;
+        blocks[thread].intervals = last - first;
+
+        kernel->fused(lut, first, last, step, &blocks[thread].state);
+
+#pragma omp single
+        threads = omp_get_num_threads();
+    }
+
+    return threads;
+}
+
+// stitches the blocks of fused_blocks_openmp onto the state in order. every
+// summation is linear so starting a block at velocity v instead of zero only
+// adds v * weight * n to its position, where weight is the summation of a
+// constant 1 over a single interval and n is the number of intervals in the
+// block.
+static void fused_blocks_join(struct sim_context* self, int32_t threads, double weight, struct fused_state* state) {
+    struct fused_block* blocks = self->blocks;
+    double vel = state->vel;
+    double pos = state->pos;
+
+    for (int32_t thread = 0; thread < threads; thread += 1) {
+        pos += blocks[thread].state.pos + vel * weight * (double)blocks[thread].intervals;
+        vel += blocks[thread].state.vel;
+    }
+
+    state->vel = vel;
+    state->pos = pos;
+}
+
+static void run_fused_openmp(struct sim_context* self, struct lut_info* lut, struct sim_result* result) {
+    int32_t threads = fused_blocks_openmp(self, lut, 1, lut->len);
+
+    profiler_lap(&self->profiler, PHASE_FUSED);
+
+    struct fused_state state;
+    state.vel = 0.0;
+    state.pos = 0.0;
+
+    fused_blocks_join(self, threads, fused_weight(self->kernel, self->args.step), &state);
+
+    profiler_lap(&self->profiler, PHASE_JOIN);
+
+    result->velocity = state.vel;
+    result->position = state.pos;
+}
+
+// joins the fused pass over a block with the fused pass over the block right
+// after it. this is the same stitching as run_fused_openmp and is associative
+// so the blocks can be joined in any grouping.
+static inline void fused_block_join(struct fused_block* left, const struct fused_block* right, double weight) {
+    left->state.pos += right->state.pos + left->state.vel * weight * (double)right->intervals;
+    left->state.vel += right->state.vel;
+    left->intervals += right->intervals;
+}
+
+// joins the blocks as a balanced tree that only depends on the number of
+// blocks. the blocks are overwritten with the partial joins.
+static void fused_pairwise(struct fused_block* chunks, int32_t count, double weight) {
+    for (int32_t width = 1; width < count; width *= 2) {
+        for (int32_t index = 0; index + width < count; index += 2 * width) {
+            fused_block_join(&chunks[index], &chunks[index + width], weight);
+        }
+    }
+}
+
+// joins the blocks in order with kahan compensation for both the velocity and
+// the position
+static void fused_kahan(struct fused_block* chunks, int32_t count, double weight) {
+    double vel = 0.0;
+    double vel_c = 0.0;
+    double pos = 0.0;
+    double pos_c = 0.0;
+
+    for (int32_t index = 0; index < count; index += 1) {
+        double offset = vel * weight * (double)chunks[index].intervals;
+        double y = chunks[index].state.pos + offset - pos_c;
+        double t = pos + y;
+
+        pos_c = (t - pos) - y;
+        pos = t;
+
+        y = chunks[index].state.vel - vel_c;
+        t = vel + y;
+
+        vel_c = (t - vel) - y;
+        vel = t;
+    }
+
+    chunks[0].state.vel = vel;
+    chunks[0].state.pos = pos;
+}
+
+// runs the simulation over blocks of block_len intervals instead of
+// one block per thread. each block is computed on its own starting from zero
+// so which thread computes it does not matter, and the blocks are then
+// combined with a reduction whose order only depends on the number of blocks.
+// this makes the result identical for any number of threads.
+static void run_deterministic(struct sim_context* self, struct lut_info* lut, struct sim_result* result) {
+    const struct lut_kernel* kernel = self->kernel;
+    struct fused_block* chunks = self->chunks;
+    double* sums = self->chunk_sums;
+    int32_t step = self->args.step;
+    int32_t block_len = self->block_len;
+    int32_t count = (int32_t)reduction_chunks(lut->len, block_len);
+    int32_t pairwise = self->args.reduction == REDUCTION_PAIRWISE;
+
+    if (self->args.fused) {
+#pragma omp parallel for schedule(runtime) num_threads(self->args.threads)
+        for (int32_t chunk = 0; chunk < count; chunk += 1) {
+            int32_t first;
+            int32_t last;
+
+            chunk_range(lut->len, block_len, chunk, &first, &last);
+
+            chunks[chunk].state.vel = 0.0;
+            chunks[chunk].state.pos = 0.0;
+            chunks[chunk].intervals = last - first;
+
+            kernel->fused(lut, first, last, step, &chunks[chunk].state);
+        }
+
+        profiler_lap(&self->profiler, PHASE_FUSED);
+
+        double weight = fused_weight(kernel, step);
+
+        if (pairwise) {
+            fused_pairwise(chunks, count, weight);
+        } else {
+            fused_kahan(chunks, count, weight);
+        }
+
+        profiler_lap(&self->profiler, PHASE_JOIN);
+
+        result->velocity = chunks[0].state.vel;
+        result->position = chunks[0].state.pos;
+
+        return;
+    }
+
+    struct lut_info* vel_lut = &self->vel_lut;
+
+#pragma omp parallel num_threads(self->args.threads)
+    {
+#pragma omp for schedule(runtime)
+        for (int32_t chunk = 0; chunk < count; chunk += 1) {
+            int32_t first;
+            int32_t last;
+
+            chunk_range(lut->len, block_len, chunk, &first, &last);
+
+            sums[chunk] = kernel->cumulate(lut, first, last, step, 0.0, vel_lut->lut);
+        }
+
+        // the loop ends with a barrier so whichever thread runs the single
+        // ends the phase after every block is done
+#pragma omp single nowait
+        profiler_lap(&self->profiler, PHASE_VELOCITY);
+
+        // the start of each block is the total of the blocks before it. the
+        // block totals are turned into that exclusive prefix by one thread
+        // since there are only a few of them. every start is needed so the
+        // scan is sequential in both modes, with kahan compensation so it is
+        // at least as accurate as the tree that joins the fused blocks
+#pragma omp single
+        {
+            double total = 0.0;
+            double compensation = 0.0;
+
+            for (int32_t chunk = 0; chunk < count; chunk += 1) {
+                double y = sums[chunk] - compensation;
+                double t = total + y;
+
+                sums[chunk] = total;
+
+                compensation = (t - total) - y;
+                total = t;
+            }
+        }
+
+#pragma omp for schedule(runtime)
+        for (int32_t chunk = 0; chunk < count; chunk += 1) {
+            int32_t first;
+            int32_t last;
+
+            chunk_range(lut->len, block_len, chunk, &first, &last);
+            double offset = sums[chunk];
+
+            if (offset != 0.0) {
+                for (int32_t index = first; index < last; index += 1) {
+                    vel_lut->lut[index] += offset;
+                }
+            }
+        }
+
+#pragma omp single nowait
+        profiler_lap(&self->profiler, PHASE_SCAN);
+
+#pragma omp for schedule(runtime)
+        for (int32_t chunk = 0; chunk < count; chunk += 1) {
+            int32_t first;
+            int32_t last;
+
+            chunk_range(lut->len, block_len, chunk, &first, &last);
+
+            sums[chunk] = kernel->position(lut, vel_lut, first, last, step);
+        }
+    }
+
+    profiler_lap(&self->profiler, PHASE_POSITION);
+
+    result->velocity = vel_lut->lut[vel_lut->len - 1];
+    result->position = pairwise ? parallel_pairwise_sum(sums, count) : parallel_kahan_sum(sums, count);
+
+    profiler_lap(&self->profiler, PHASE_JOIN);
+}
+
+static void run_openmp(struct sim_context* self, struct lut_info* lut, struct sim_result* result) {
+    if (self->args.fused) {
+        run_fused_openmp(self, lut, result);
+
+        return;
+    }
+
+    const struct lut_kernel* kernel = self->kernel;
+    struct lut_info* vel_lut = &self->vel_lut;
+    double* partials = self->partials;
+    int32_t step = self->args.step;
+
+    // blocked parallel scan of the velocity. each thread integrates its block
+    // as a local running total and records the block total, then after a
+    // barrier shifts its block by the totals of the blocks before it. this
+    // replaces the serial scan over the whole table.
+#pragma omp parallel num_threads(self->args.threads)
+    {
+        int32_t thread = omp_get_thread_num();
+        int32_t first;
+        int32_t last;
+
+        parallel_thread_range(1, lut->len, &first, &last);
+
+        partials[thread * THREAD_PAD] = kernel->cumulate(
+            lut,
+            first,
+            last,
+            step,
+            0.0,
+            vel_lut->lut
+        );
+
+#pragma omp barrier
+
+#pragma omp master
+        profiler_lap(&self->profiler, PHASE_VELOCITY);
+
+        double offset = parallel_thread_offset(partials, thread);
+
+        if (offset != 0.0) {
+            for (int32_t index = first; index < last; index += 1) {
+                vel_lut->lut[index] += offset;
+            }
+        }
+    }
+
+    profiler_lap(&self->profiler, PHASE_SCAN);
+
+    double pos_final = 0.0;
+
+    if (self->args.schedule != SCHEDULE_DEFAULT) {
+        // the position pass does not depend on the order of the blocks so
+        // it can be spread over the threads with the requested schedule
+        int32_t block_len = self->block_len;
+        int32_t count = (int32_t)reduction_chunks(vel_lut->len, block_len);
+
+#pragma omp parallel for schedule(runtime) num_threads(self->args.threads) reduction(+:pos_final)
+        for (int32_t chunk = 0; chunk < count; chunk += 1) {
+            int32_t first;
+            int32_t last;
+
+            chunk_range(vel_lut->len, block_len, chunk, &first, &last);
+
+            pos_final += kernel->position(lut, vel_lut, first, last, step);
+        }
+    } else {
+#pragma omp parallel num_threads(self->args.threads) reduction(+:pos_final)
+        {
+            int32_t first;
+            int32_t last;
+
+            parallel_thread_range(1, vel_lut->len, &first, &last);
+
+            pos_final += kernel->position(lut, vel_lut, first, last, step);
+        }
+    }
+
+    profiler_lap(&self->profiler, PHASE_POSITION);
+
+    result->velocity = vel_lut->lut[vel_lut->len - 1];
+    result->position = pos_final;
+}
+
+// runs the fused pass one interval at a time over [first, last) and stores the
+// state after each interval in out
+static void trajectory_block(
+    const struct lut_kernel* kernel,
+    struct lut_info* lut,
+    int32_t first,
+    int32_t last,
+    int32_t step,
+    struct fused_state* state,
+    struct trajectory_sample* out
+) {
+    for (int32_t sec = first; sec < last; sec += 1) {
+        kernel->fused(lut, sec, sec + 1, step, state);
+
+        out->time = (double)sec;
+        out->accel = lut->lut[sec];
+        out->vel = state->vel;
+        out->pos = state->pos;
+        out += 1;
+    }
+}
+
+// same as run_fused_openmp but for a chunk of the table that is written into
+// the trajectory buffer. each thread runs its block from zero then shifts
+// every sample in it by the state of the blocks before it.
+static void trajectory_chunk_openmp(
+    struct sim_context* self,
+    struct lut_info* lut,
+    int32_t begin,
+    int32_t end,
+    double weight,
+    struct fused_state* state,
+    struct trajectory_sample* out
+) {
+    const struct lut_kernel* kernel = self->kernel;
+    struct fused_block* blocks = self->blocks;
+    int32_t step = self->args.step;
+    struct fused_state start = *state;
+
+#pragma omp parallel num_threads(self->args.threads)
+    {
+        int32_t thread = omp_get_thread_num();
+        int32_t first;
+        int32_t last;
+
+        parallel_thread_range(begin, end, &first, &last);
+
+        blocks[thread].state.vel = 0.0;
+        blocks[thread].state.pos = 0.0;
+        blocks[thread].intervals = last - first;
+
+        trajectory_block(kernel, lut, first, last, step, &blocks[thread].state, out + (first - begin));
+
+#pragma omp barrier
+
+        double vel = start.vel;
+        double pos = start.pos;
+
+        for (int32_t prev = 0; prev < thread; prev += 1) {
+            pos += blocks[prev].state.pos + vel * weight * (double)blocks[prev].intervals;
+            vel += blocks[prev].state.vel;
+        }
+
+        struct trajectory_sample* iter = out + (first - begin);
+
+        for (int32_t sec = first; sec < last; sec += 1) {
+            iter->pos += pos + vel * weight * (double)(sec - first + 1);
+            iter->vel += vel;
+            iter += 1;
+        }
+    }
+
+    state->vel = out[end - begin - 1].vel;
+    state->pos = out[end - begin - 1].pos;
+}
+
+// runs a single simulation over the table and writes the time, acceleration,
+// velocity and position at every entry of the table to the writer. the table
+// is simulated in chunks the size of the writer's buffers so the writer
+// thread is writing out the previous chunk while the next one is computed.
+int32_t sim_context_trajectory(
+    struct sim_context* self,
+    struct lut_info* lut,
+    struct trajectory_writer* writer,
+    struct sim_result* result
+) {
+    if (lut->len < 2) {
+        fprintf(stderr, "acceleration profile must contain at least 2 entries\n");
+
+        return 1;
+    }
+
+    const struct lut_kernel* kernel = self->kernel;
+    int32_t step = self->args.step;
+    double weight = fused_weight(kernel, step);
+
+    struct fused_state state;
+    state.vel = 0.0;
+    state.pos = 0.0;
+
+    size_t available = 0;
+    struct trajectory_sample* out = trajectory_writer_reserve(writer, &available);
+
+    out->time = 0.0;
+    out->accel = lut->lut[0];
+    out->vel = 0.0;
+    out->pos = 0.0;
+
+    if (trajectory_writer_commit(writer, 1) != 0) {
+        return 1;
+    }
+
+    int32_t sec = 1;
+
+    while (sec < lut->len) {
+        out = trajectory_writer_reserve(writer, &available);
+
+        int32_t count = lut->len - sec;
+
+        if ((size_t)count > available) {
+            count = (int32_t)available;
+        }
+
+        if (self->args.threads == 1) {
+            trajectory_block(kernel, lut, sec, sec + count, step, &state, out);
+        } else {
+            trajectory_chunk_openmp(self, lut, sec, sec + count, weight, &state, out);
+        }
+
+        if (trajectory_writer_commit(writer, (size_t)count) != 0) {
+            return 1;
+        }
+
+        sec += count;
+    }
+
+    result->velocity = state.vel;
+    result->position = state.pos;
+
+    return 0;
+}
+
+// same as sim_context_trajectory but the state at every entry of the table is
+// stored in out, which must hold lut->len samples, instead of being written
+// out as it is computed
+int32_t sim_context_samples(
+    struct sim_context* self,
+    struct lut_info* lut,
+    struct trajectory_sample* out,
+    struct sim_result* result
+) {
+    if (lut->len < 2) {
+        fprintf(stderr, "acceleration profile must contain at least 2 entries\n");
+
+        return 1;
+    }
+
+    struct fused_state state;
+    state.vel = 0.0;
+    state.pos = 0.0;
+
+    out->time = 0.0;
+    out->accel = lut->lut[0];
+    out->vel = 0.0;
+    out->pos = 0.0;
+
+    if (self->args.threads == 1) {
+        trajectory_block(self->kernel, lut, 1, lut->len, self->args.step, &state, out + 1);
+    } else {
+        double weight = fused_weight(self->kernel, self->args.step);
+
+        trajectory_chunk_openmp(self, lut, 1, lut->len, weight, &state, out + 1);
+    }
+
+    result->velocity = state.vel;
+    result->position = state.pos;
+
+    return 0;
+}
+
+// runs the fused pass over a profile as its chunks arrive from the reader.
+// the velocity and position at the end of each chunk are where the next one
+// starts so the result is the same as a fused pass over the whole table
+int32_t sim_context_stream(struct sim_context* self, struct stream_reader* reader, struct sim_result* result) {
+    const struct lut_kernel* kernel = self->kernel;
+    int32_t step = self->args.step;
+    double weight = fused_weight(kernel, step);
+    const struct stream_chunk* chunk;
+
+    struct fused_state state;
+    state.vel = 0.0;
+    state.pos = 0.0;
+
+    while ((chunk = stream_reader_next(reader)) != NULL) {
+        struct lut_info lut;
+        lut.len = chunk->len;
+        lut.lut = chunk->values;
+
+        // only the first chunk of a file holding a single entry has no
+        // intervals
+        if (lut.len > 1 && self->args.threads == 1) {
+            kernel->fused(&lut, 1, lut.len, step, &state);
+        } else if (lut.len > 1) {
+            int32_t threads = fused_blocks_openmp(self, &lut, 1, lut.len);
+
+            fused_blocks_join(self, threads, weight, &state);
+        }
+
+        stream_reader_release(reader);
+    }
+
+    if (reader->failed) {
+        return 1;
+    }
+
+    if (reader->entries < 2) {
+        fprintf(stderr, "acceleration profile must contain at least 2 entries\n");
+
+        return 1;
+    }
+
+    result->velocity = state.vel;
+    result->position = state.pos;
+
+    return 0;
+}
+
+// checks the table and sizes the velocity table to match it
+static int32_t sim_context_prepare(struct sim_context* self, struct lut_info* lut) {
+    if (lut->len < 2) {
+        fprintf(stderr, "acceleration profile must contain at least 2 entries\n");
+
+        return 1;
+    }
+
+    if (sim_context_reserve(self, lut->len) != 0) {
+        return 1;
+    }
+
+    self->vel_lut.len = lut->len;
+
+    if (self->vel_lut.lut != NULL) {
+        self->vel_lut.lut[0] = 0.0;
+    }
+
+    return 0;
+}
+
+// runs a single timed simulation over the given table and adds the time it
+// took to the timing of the context
+int32_t sim_context_run(struct sim_context* self, struct lut_info* lut, struct sim_result* result) {
+    if (sim_context_prepare(self, lut) != 0) {
+        return 1;
+    }
+
+    struct timespec start;
+    struct timespec end;
+    struct timespec diff;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &start) != 0) {
+        fprintf(stderr, "failed to retrieve start time\n");
+
+        return 1;
+    }
+
+    // the block loops use schedule(runtime) so the schedule is set by the
+    // context that runs them
+    set_omp_schedule(self->args.schedule);
+    self->profiler.samples = (uint64_t)(lut->len - 1);
+    profiler_start(&self->profiler);
+
+    if (self->args.reduction != REDUCTION_THREAD) {
+        run_deterministic(self, lut, result);
+    } else if (self->args.threads == 1) {
+        run_serial(self, lut, result);
+    } else {
+        run_openmp(self, lut, result);
+    }
+
+    profiler_finish(&self->profiler);
+
+    if (clock_gettime(CLOCK_MONOTONIC, &end) != 0) {
+        fprintf(stderr, "failed failed to retrieve end time. %s\n", strerror(errno));
+
+        return 1;
+    }
+
+    timespec_diff(&start, &end, &diff);
+
+    timing_update(&self->time_data, &diff);
+
+    return 0;
+}
+
+// prints the timing of the context whenever the log timer elapses
+static void log_iteration(struct sim_context* self, int32_t iteration) {
+    switch (log_timer_update(&self->log_time)) {
+    case 1:
+        printf("iteration: %d\n", iteration);
+
+        timing_print(&self->time_data);
+        break;
+    case 0:
+        // all good
+        break;
+    case -1:
+        fprintf(stderr, "error when updating log_timer\n");
+        break;
+    }
+}
+
+// one iteration of a persistent region. every thread calls this with its own
+// block of the table and the phases are separated by barriers instead of the
+// end of a region.
+static void persistent_iteration(
+    struct sim_context* self,
+    struct lut_info* lut,
+    int32_t thread,
+    int32_t first,
+    int32_t last
+) {
+    const struct lut_kernel* kernel = self->kernel;
+    struct fused_block* block = &self->blocks[thread];
+    int32_t step = self->args.step;
+
+    if (self->args.fused) {
+        block->state.vel = 0.0;
+        block->state.pos = 0.0;
+        block->intervals = last - first;
+
+        kernel->fused(lut, first, last, step, &block->state);
+
+        return;
+    }
+
+    struct lut_info* vel_lut = &self->vel_lut;
+    double* partials = self->partials;
+
+    partials[thread * THREAD_PAD] = kernel->cumulate(lut, first, last, step, 0.0, vel_lut->lut);
+
+#pragma omp barrier
+
+#pragma omp master
+    profiler_lap(&self->profiler, PHASE_VELOCITY);
+
+    double offset = parallel_thread_offset(partials, thread);
+
+    if (offset != 0.0) {
+        for (int32_t index = first; index < last; index += 1) {
+            vel_lut->lut[index] += offset;
+        }
+    }
+
+    // the position of a block reads the last velocity of the block before it
+#pragma omp barrier
+
+#pragma omp master
+    profiler_lap(&self->profiler, PHASE_SCAN);
+
+    double pos = 0.0;
+
+    if (self->args.schedule != SCHEDULE_DEFAULT) {
+        int32_t block_len = self->block_len;
+        int32_t count = (int32_t)reduction_chunks(vel_lut->len, block_len);
+
+#pragma omp for schedule(runtime) nowait
+        for (int32_t chunk = 0; chunk < count; chunk += 1) {
+            int32_t chunk_first;
+            int32_t chunk_last;
+
+            chunk_range(vel_lut->len, block_len, chunk, &chunk_first, &chunk_last);
+
+            pos += kernel->position(lut, vel_lut, chunk_first, chunk_last, step);
+        }
+    } else {
+        pos = kernel->position(lut, vel_lut, first, last, step);
+    }
+
+    block->state.pos = pos;
+}
+
+// runs the simulation the given number of times, timing and logging each
+// iteration. with args.persistent all of the iterations run inside of a
+// single parallel region where the threads keep the same block of the table
+// and only meet at barriers, so the cost of starting and joining a region is
+// paid once instead of once or twice per iteration. the deterministic
+// reductions and a single thread always run through sim_context_run.
+int32_t sim_context_run_iterations(
+    struct sim_context* self,
+    struct lut_info* lut,
+    int32_t iterations,
+    struct sim_result* result
+) {
+    if (!self->args.persistent || self->args.threads == 1 || self->args.reduction != REDUCTION_THREAD) {
+        for (int32_t c = 0; c < iterations; c += 1) {
+            if (sim_context_run(self, lut, result) != 0) {
+                return 1;
+            }
+
+            log_iteration(self, c);
+        }
+
+        return 0;
+    }
+
+    if (sim_context_prepare(self, lut) != 0) {
+        return 1;
+    }
+
+    set_omp_schedule(self->args.schedule);
+    self->profiler.samples = (uint64_t)(lut->len - 1);
+
+    double weight = fused_weight(self->kernel, self->args.step);
+    int32_t failed = 0;
+    struct timespec start;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &start) != 0) {
+        fprintf(stderr, "failed to retrieve start time\n");
+
+        return 1;
+    }
+
+#pragma omp parallel num_threads(self->args.threads)
+    {
+        int32_t thread = omp_get_thread_num();
+        int32_t threads = omp_get_num_threads();
+        int32_t first;
+        int32_t last;
+
+        parallel_thread_range(1, lut->len, &first, &last);
+
+#pragma omp master
+        profiler_start(&self->profiler);
+
+        for (int32_t c = 0; c < iterations && !failed; c += 1) {
+            persistent_iteration(self, lut, thread, first, last);
+
+#pragma omp barrier
+
+            // the implied barrier at the end of the single keeps the next
+            // iteration from overwriting the blocks while they are joined
+#pragma omp single
+            {
+                struct fused_block* blocks = self->blocks;
+                double vel = 0.0;
+                double pos = 0.0;
+
+                profiler_lap(&self->profiler, self->args.fused ? PHASE_FUSED : PHASE_POSITION);
+
+                if (self->args.fused) {
+                    for (int32_t prev = 0; prev < threads; prev += 1) {
+                        pos += blocks[prev].state.pos + vel * weight * (double)blocks[prev].intervals;
+                        vel += blocks[prev].state.vel;
+                    }
+                } else {
+                    for (int32_t prev = 0; prev < threads; prev += 1) {
+                        pos += blocks[prev].state.pos;
+                    }
+
+                    vel = self->vel_lut.lut[self->vel_lut.len - 1];
+                }
+
+                result->velocity = vel;
+                result->position = pos;
+
+                profiler_lap(&self->profiler, PHASE_JOIN);
+                profiler_finish(&self->profiler);
+                profiler_start(&self->profiler);
+
+                struct timespec end;
+                struct timespec diff;
+
+                if (clock_gettime(CLOCK_MONOTONIC, &end) != 0) {
+                    fprintf(stderr, "failed to retrieve end time. %s\n", strerror(errno));
+
+                    failed = 1;
+                } else {
+                    timespec_diff(&start, &end, &diff);
+                    timing_update(&self->time_data, &diff);
+                    log_iteration(self, c);
+
+                    start = end;
+                }
+            }
+        }
+    }
+
+    return failed;
+}
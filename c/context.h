@@ -0,0 +1,83 @@
+#ifndef CONTEXT_H
+#define CONTEXT_H
+
+#include <stdint.h>
+
+#include "arena.h"
+#include "args.h"
+#include "kernels.h"
+#include "stream.h"
+#include "summation.h"
+#include "trajectory.h"
+#include "ts.h"
+
+struct sim_result {
+    double velocity;
+    double position;
+};
+
+// the default number of intervals in each block when the blocks are combined
+// with a deterministic reduction or spread with --schedule
+#define REDUCTION_BLOCK_LEN 4096
+
+// the result of a single thread's fused pass over its block of the table
+struct fused_block {
+    struct fused_state state;
+    int32_t intervals;
+} __attribute__((aligned(64)));
+
+// everything a simulation needs that does not depend on the data being
+// simulated. the kernel is resolved and the scratch buffers are allocated
+// once when the context is created so repeated runs only do the work of the
+// simulation itself.
+struct sim_context {
+    struct sim_args args;
+    const struct lut_kernel* kernel;
+
+    struct arena arena;
+    // the largest table the scratch buffers are able to hold
+    int32_t capacity;
+
+    struct lut_info vel_lut;
+    // the total of each thread's block of the velocity table
+    double* partials;
+    struct fused_block* blocks;
+    // the fixed size blocks used by the deterministic reductions and the
+    // scheduled block loops
+    int32_t block_len;
+    struct fused_block* chunks;
+    double* chunk_sums;
+
+    struct timing time_data;
+    struct log_timer log_time;
+    struct profiler profiler;
+};
+
+int32_t sim_context_init(struct sim_context* self, struct sim_args* args, int32_t capacity);
+void sim_context_free(struct sim_context* self);
+
+int32_t sim_context_reserve(struct sim_context* self, int32_t capacity);
+void sim_context_configure(struct sim_context* self, int32_t algo, int32_t step);
+
+int32_t sim_context_run(struct sim_context* self, struct lut_info* lut, struct sim_result* result);
+int32_t sim_context_run_iterations(
+    struct sim_context* self,
+    struct lut_info* lut,
+    int32_t iterations,
+    struct sim_result* result
+);
+int32_t sim_context_trajectory(
+    struct sim_context* self,
+    struct lut_info* lut,
+    struct trajectory_writer* writer,
+    struct sim_result* result
+);
+int32_t sim_context_samples(
+    struct sim_context* self,
+    struct lut_info* lut,
+    struct trajectory_sample* out,
+    struct sim_result* result
+);
+int32_t sim_context_stream(struct sim_context* self, struct stream_reader* reader, struct sim_result* result);
+
+#endif
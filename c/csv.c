@@ -0,0 +1,237 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "csv.h"
+
+// the powers of ten that are exactly representable as a double. dividing an
+// exactly representable mantissa by one of these gives a correctly rounded
+// result so the fast path matches strtod bit for bit.
+static const double EXACT_POW10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+#define EXACT_POW10_MAX 22
+#define EXACT_MANTISSA_MAX (1ULL << 53)
+
+int32_t csv_reader_open(struct csv_reader* self, const char* file_path, size_t buffer_size) {
+    self->fd = open(file_path, O_RDONLY);
+    self->buffer = NULL;
+    self->capacity = buffer_size;
+    self->pos = 0;
+    self->end = 0;
+    self->eof = 0;
+    self->line = 0;
+    self->bytes = 0;
+
+    if (self->fd < 0) {
+        fprintf(stderr, "failed to open csv file \"%s\". %s\n", file_path, strerror(errno));
+
+        return 1;
+    }
+
+    // the extra byte is used to keep the buffered data null terminated for
+    // the strtod fallback
+    self->buffer = (char*)malloc(buffer_size + 1);
+
+    if (self->buffer == NULL) {
+        fprintf(stderr, "failed allocating csv read buffer. %s\n", strerror(errno));
+
+        close(self->fd);
+        self->fd = -1;
+
+        return 1;
+    }
+
+#ifdef POSIX_FADV_SEQUENTIAL
+    posix_fadvise(self->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+    return 0;
+}
+
+void csv_reader_close(struct csv_reader* self) {
+    if (self->fd >= 0) {
+        close(self->fd);
+        self->fd = -1;
+    }
+
+    free(self->buffer);
+    self->buffer = NULL;
+}
+
+// moves any partial line to the front of the buffer and fills the rest from
+// the file
+static int32_t csv_reader_fill(struct csv_reader* self) {
+    size_t remaining = self->end - self->pos;
+
+    if (remaining > 0 && self->pos > 0) {
+        memmove(self->buffer, self->buffer + self->pos, remaining);
+    }
+
+    self->pos = 0;
+    self->end = remaining;
+
+    while (self->end < self->capacity) {
+        ssize_t amount = read(self->fd, self->buffer + self->end, self->capacity - self->end);
+
+        if (amount < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            fprintf(stderr, "failed reading csv file. %s\n", strerror(errno));
+
+            return 1;
+        }
+
+        if (amount == 0) {
+            self->eof = 1;
+
+            break;
+        }
+
+        self->end += (size_t)amount;
+        self->bytes += (uint64_t)amount;
+    }
+
+    self->buffer[self->end] = '\0';
+
+    return 0;
+}
+
+// parses a plain decimal number in the form [+-]digits[.digits] without going
+// through strtod. anything else (exponents, inf/nan, long mantissas) is handed
+// off to strtod so the result is always the correctly rounded value.
+int32_t csv_parse_double(const char* str, const char** endptr, double* value) {
+    const char* iter = str;
+    int32_t negative = 0;
+
+    if (*iter == '-') {
+        negative = 1;
+        iter += 1;
+    } else if (*iter == '+') {
+        iter += 1;
+    }
+
+    uint64_t mantissa = 0;
+    int32_t digits = 0;
+    int32_t frac_digits = 0;
+
+    while (*iter >= '0' && *iter <= '9') {
+        mantissa = mantissa * 10 + (uint64_t)(*iter - '0');
+        digits += 1;
+        iter += 1;
+    }
+
+    if (*iter == '.') {
+        iter += 1;
+
+        while (*iter >= '0' && *iter <= '9') {
+            mantissa = mantissa * 10 + (uint64_t)(*iter - '0');
+            digits += 1;
+            frac_digits += 1;
+            iter += 1;
+        }
+    }
+
+    if (
+        digits > 0 &&
+        digits <= 19 &&
+        frac_digits <= EXACT_POW10_MAX &&
+        mantissa <= EXACT_MANTISSA_MAX &&
+        *iter != 'e' && *iter != 'E'
+    ) {
+        double result = (double)mantissa / EXACT_POW10[frac_digits];
+
+        *value = negative ? -result : result;
+        *endptr = iter;
+
+        return 0;
+    }
+
+    char* fallback_end;
+    *value = strtod(str, &fallback_end);
+    *endptr = fallback_end;
+
+    if (fallback_end == str) {
+        return 1;
+    }
+
+    return 0;
+}
+
+// parses up to max values from the file into the given array. count will be 0
+// once the end of the file has been reached.
+int32_t csv_reader_next(struct csv_reader* self, double* values, size_t max, size_t* count) {
+    *count = 0;
+
+    while (*count < max) {
+        char* line_start = self->buffer + self->pos;
+        char* line_end = (char*)memchr(line_start, '\n', self->end - self->pos);
+
+        if (line_end == NULL) {
+            if (!self->eof) {
+                if (self->pos == 0 && self->end == self->capacity) {
+                    fprintf(stderr, "csv line is larger than the read buffer. %ld\n", (long)self->line + 1);
+
+                    return 1;
+                }
+
+                if (csv_reader_fill(self) != 0) {
+                    return 1;
+                }
+
+                continue;
+            }
+
+            if (self->pos == self->end) {
+                break;
+            }
+
+            // the last line of the file without a trailing newline
+            line_end = self->buffer + self->end;
+        }
+
+        self->line += 1;
+        self->pos = (size_t)(line_end - self->buffer);
+
+        if (self->pos < self->end) {
+            self->pos += 1;
+        }
+
+        char* iter = line_start;
+
+        while (*iter == ' ' || *iter == '\t') {
+            iter += 1;
+        }
+
+        if (iter == line_end || *iter == '\r') {
+            continue;
+        }
+
+        const char* parsed_end;
+        double value;
+        int32_t invalid = csv_parse_double(iter, &parsed_end, &value) != 0 || parsed_end > line_end;
+
+        while (!invalid && parsed_end < line_end && (*parsed_end == ' ' || *parsed_end == '\t')) {
+            parsed_end += 1;
+        }
+
+        if (invalid || (parsed_end != line_end && *parsed_end != ',' && *parsed_end != '\r')) {
+            fprintf(stderr, "failed to convert csv entry into float. %ld\n", (long)self->line);
+
+            return 1;
+        }
+
+        values[*count] = value;
+        *count += 1;
+    }
+
+    return 0;
+}
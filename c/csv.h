@@ -0,0 +1,32 @@
+#ifndef CSV_H
+#define CSV_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// default size of the read buffer used when streaming a csv file
+#define CSV_BUFFER_SIZE (1 << 20)
+
+// streaming reader for csv files where the first column of each line holds a
+// floating point value. the file is read through a single fixed size buffer
+// so the size of the file does not matter and no allocations happen per line.
+struct csv_reader {
+    int fd;
+    char* buffer;
+    size_t capacity;
+    // the unparsed region of the buffer is [pos, end)
+    size_t pos;
+    size_t end;
+    int32_t eof;
+    int64_t line;
+    uint64_t bytes;
+};
+
+int32_t csv_reader_open(struct csv_reader* self, const char* file_path, size_t buffer_size);
+void csv_reader_close(struct csv_reader* self);
+
+int32_t csv_reader_next(struct csv_reader* self, double* values, size_t max, size_t* count);
+
+int32_t csv_parse_double(const char* str, const char** endptr, double* value);
+
+#endif
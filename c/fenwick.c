@@ -0,0 +1,66 @@
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fenwick.h"
+
+int32_t fenwick_init(struct fenwick* self, int32_t len) {
+    self->len = len;
+    // the tree is 1 indexed so index 0 is never used
+    self->tree = (double*)calloc((size_t)len + 1, sizeof(double));
+
+    if (self->tree == NULL) {
+        fprintf(stderr, "failed allocating fenwick tree. %s\n", strerror(errno));
+
+        self->len = 0;
+
+        return 1;
+    }
+
+    return 0;
+}
+
+void fenwick_free(struct fenwick* self) {
+    free(self->tree);
+
+    self->tree = NULL;
+    self->len = 0;
+}
+
+// builds the tree from the given values in O(n) by pushing each node's total
+// up to its parent once instead of doing an update per value. the values are
+// allowed to already be in the tree's storage at tree + 1.
+void fenwick_build(struct fenwick* self, const double* values) {
+    double* tree = self->tree;
+
+    memmove(tree + 1, values, (size_t)self->len * sizeof(double));
+
+    for (int64_t node = 1; node <= self->len; node += 1) {
+        int64_t parent = node + (node & -node);
+
+        if (parent <= self->len) {
+            tree[parent] += tree[node];
+        }
+    }
+}
+
+// adds delta to the value at the given 0 based index
+void fenwick_add(struct fenwick* self, int32_t index, double delta) {
+    // 64 bit so the last step past the end of a large tree can not overflow
+    for (int64_t node = (int64_t)index + 1; node <= self->len; node += node & -node) {
+        self->tree[node] += delta;
+    }
+}
+
+// the sum of the values from 0 up to and including the given index
+double fenwick_prefix(const struct fenwick* self, int32_t index) {
+    double total = 0.0;
+
+    for (int32_t node = index + 1; node > 0; node -= node & -node) {
+        total += self->tree[node];
+    }
+
+    return total;
+}
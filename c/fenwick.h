@@ -0,0 +1,20 @@
+#ifndef FENWICK_H
+#define FENWICK_H
+
+#include <stdint.h>
+
+// binary indexed tree of prefix sums over len values. changing a single value
+// and retrieving the sum of the values up to an index are both O(log n).
+struct fenwick {
+    double* tree;
+    int32_t len;
+};
+
+int32_t fenwick_init(struct fenwick* self, int32_t len);
+void fenwick_free(struct fenwick* self);
+
+void fenwick_build(struct fenwick* self, const double* values);
+void fenwick_add(struct fenwick* self, int32_t index, double delta);
+double fenwick_prefix(const struct fenwick* self, int32_t index);
+
+#endif
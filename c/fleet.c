@@ -0,0 +1,356 @@
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+
+#include "args.h"
+#include "fleet.h"
+#include "kernels.h"
+#include "profile.h"
+
+typedef double fleet_vec __attribute__((vector_size(FLEET_LANES * sizeof(double))));
+
+// integrates every train of a block over the whole table. every train of
+// the block is a lane of the vectors so each step of the loop advances all of
+// them at once.
+#define DEFINE_FLEET_BLOCK(name, attr)                                       \
+attr static void name(                                                       \
+    const double* data,                                                      \
+    int32_t len,                                                             \
+    const struct lut_interval_coeffs* coeff,                                  \
+    double* velocity,                                                        \
+    double* position                                                         \
+) {                                                                          \
+    const fleet_vec* rows = (const fleet_vec*)data;                          \
+    fleet_vec vel = {0};                                                     \
+    fleet_vec pos = {0};                                                     \
+    fleet_vec a0 = rows[0];                                                  \
+                                                                             \
+    for (int32_t sec = 1; sec < len; sec += 1) {                             \
+        fleet_vec a1 = rows[sec];                                            \
+        fleet_vec slope = a1 - a0;                                           \
+                                                                             \
+        pos += coeff->q0 * vel + coeff->j0 * a0 + coeff->j1 * slope;         \
+        vel += coeff->i0 * a0 + coeff->i1 * slope;                           \
+        a0 = a1;                                                             \
+    }                                                                        \
+                                                                             \
+    memcpy(velocity, &vel, sizeof(vel));                                     \
+    memcpy(position, &pos, sizeof(pos));                                     \
+}
+
+typedef void (*fleet_block_fn)(
+    const double* data,
+    int32_t len,
+    const struct lut_interval_coeffs* coeff,
+    double* velocity,
+    double* position
+);
+
+DEFINE_FLEET_BLOCK(fleet_block_scalar, )
+
+#if defined(__x86_64__) || defined(__i386__)
+
+DEFINE_FLEET_BLOCK(fleet_block_avx2, __attribute__((target("avx2,fma"))))
+DEFINE_FLEET_BLOCK(fleet_block_avx512, __attribute__((target("avx512f,fma"))))
+
+#endif
+
+// the block kernel for the instruction set the lut kernels were selected for
+static fleet_block_fn fleet_block_kernel() {
+    switch (lut_kernel_isa()) {
+#if defined(__x86_64__) || defined(__i386__)
+    case ISA_AVX2:
+        return fleet_block_avx2;
+    case ISA_AVX512:
+        return fleet_block_avx512;
+#endif
+    default:
+        return fleet_block_scalar;
+    }
+}
+
+void fleet_init(struct fleet* self) {
+    self->data = NULL;
+    self->trains = 0;
+    self->len = 0;
+    self->blocks = 0;
+    self->paths = NULL;
+    self->velocity = NULL;
+    self->position = NULL;
+}
+
+void fleet_free(struct fleet* self) {
+    if (self->paths != NULL) {
+        for (int32_t train = 0; train < self->trains; train += 1) {
+            free(self->paths[train]);
+        }
+    }
+
+    free(self->data);
+    free(self->paths);
+    free(self->velocity);
+
+    fleet_init(self);
+}
+
+// allocates the blocks for the given number of trains of len entries each.
+// every entry starts at zero.
+int32_t fleet_reserve(struct fleet* self, int32_t trains, int32_t len) {
+    fleet_free(self);
+
+    if (trains < 1 || len < 2) {
+        fprintf(stderr, "a fleet needs at least 1 train with at least 2 entries\n");
+
+        return 1;
+    }
+
+    int32_t blocks = (trains + FLEET_LANES - 1) / FLEET_LANES;
+    size_t bytes = (size_t)blocks * (size_t)len * FLEET_LANES * sizeof(double);
+
+    // a block row is exactly the size of a fleet_vec so the size is always a
+    // multiple of the alignment
+    self->data = (double*)aligned_alloc(sizeof(fleet_vec), bytes);
+    self->velocity = (double*)malloc((size_t)blocks * FLEET_LANES * 2 * sizeof(double));
+
+    if (self->data == NULL || self->velocity == NULL) {
+        fprintf(stderr, "failed allocating fleet. %s\n", strerror(errno));
+
+        fleet_free(self);
+
+        return 1;
+    }
+
+    memset(self->data, 0, bytes);
+
+    self->trains = trains;
+    self->len = len;
+    self->blocks = blocks;
+    self->position = self->velocity + (size_t)blocks * FLEET_LANES;
+
+    return 0;
+}
+
+// copies a profile into the lane of the given train
+int32_t fleet_set_train(struct fleet* self, int32_t train, struct lut_info* lut) {
+    if (train < 0 || train >= self->trains) {
+        fprintf(stderr, "train %d is not part of the fleet of %d trains\n", train, self->trains);
+
+        return 1;
+    }
+
+    if (lut->len != self->len) {
+        fprintf(
+            stderr,
+            "every profile of a fleet must have the same length. train %d has %d entries instead of %d\n",
+            train,
+            lut->len,
+            self->len
+        );
+
+        return 1;
+    }
+
+    int32_t lane = train % FLEET_LANES;
+    double* block = self->data + (size_t)(train / FLEET_LANES) * (size_t)self->len * FLEET_LANES;
+
+    for (int32_t sec = 0; sec < self->len; sec += 1) {
+        block[(size_t)sec * FLEET_LANES + lane] = lut->lut[sec];
+    }
+
+    return 0;
+}
+
+static char* fleet_strip(char* str) {
+    while (*str == ' ' || *str == '\t') {
+        str += 1;
+    }
+
+    char* end = str + strlen(str);
+
+    while (end > str && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\n' || end[-1] == '\r')) {
+        end -= 1;
+    }
+
+    *end = '\0';
+
+    return str;
+}
+
+// reads the non empty lines of the list that do not start with # as paths
+static int32_t fleet_read_list(const char* list_path, char*** paths, int32_t* count) {
+    FILE* file = fopen(list_path, "r");
+
+    if (file == NULL) {
+        fprintf(stderr, "failed to open fleet list \"%s\". %s\n", list_path, strerror(errno));
+
+        return 1;
+    }
+
+    char line[4096];
+    int64_t line_num = 0;
+    int32_t capacity = 0;
+
+    *paths = NULL;
+    *count = 0;
+
+    while (fgets(line, sizeof(line), file) != NULL) {
+        line_num += 1;
+
+        // only the last line of the file may end without a newline
+        if (strchr(line, '\n') == NULL) {
+            int next = fgetc(file);
+
+            if (next != EOF) {
+                fprintf(
+                    stderr,
+                    "fleet list line is longer than %d bytes. %ld\n",
+                    (int)sizeof(line) - 2,
+                    (long)line_num
+                );
+
+                fclose(file);
+
+                return 1;
+            }
+        }
+
+        char* path = fleet_strip(line);
+
+        if (*path == '\0' || *path == '#') {
+            continue;
+        }
+
+        if (*count == capacity) {
+            capacity = capacity == 0 ? 64 : capacity * 2;
+
+            char** grown = (char**)realloc(*paths, (size_t)capacity * sizeof(char*));
+
+            if (grown == NULL) {
+                fprintf(stderr, "failed growing fleet list. %s\n", strerror(errno));
+
+                fclose(file);
+
+                return 1;
+            }
+
+            *paths = grown;
+        }
+
+        (*paths)[*count] = strdup(path);
+
+        if ((*paths)[*count] == NULL) {
+            fprintf(stderr, "failed allocating fleet path. %s\n", strerror(errno));
+
+            fclose(file);
+
+            return 1;
+        }
+
+        *count += 1;
+    }
+
+    fclose(file);
+
+    if (*count == 0) {
+        fprintf(stderr, "fleet list \"%s\" does not contain any profiles\n", list_path);
+
+        return 1;
+    }
+
+    return 0;
+}
+
+// loads every profile in the list, one path per line, into its own train.
+// each profile is copied into the fleet and released before the next one is
+// loaded so only the interleaved copy is kept in memory.
+int32_t fleet_load_list(struct fleet* self, const char* list_path) {
+    char** paths = NULL;
+    int32_t count = 0;
+
+    fleet_free(self);
+
+    if (fleet_read_list(list_path, &paths, &count) != 0) {
+        for (int32_t train = 0; train < count; train += 1) {
+            free(paths[train]);
+        }
+
+        free(paths);
+
+        return 1;
+    }
+
+    int32_t rtn = 0;
+
+    for (int32_t train = 0; train < count && rtn == 0; train += 1) {
+        struct profile profile;
+        profile_init(&profile);
+
+        if (profile_load(paths[train], &profile) != 0) {
+            rtn = 1;
+
+            break;
+        }
+
+        if (train == 0) {
+            rtn = fleet_reserve(self, count, profile.lut.len);
+        }
+
+        if (rtn == 0 && fleet_set_train(self, train, &profile.lut) != 0) {
+            fprintf(stderr, "failed adding \"%s\" to the fleet\n", paths[train]);
+
+            rtn = 1;
+        }
+
+        profile_free(&profile);
+    }
+
+    if (rtn != 0) {
+        fleet_free(self);
+
+        for (int32_t train = 0; train < count; train += 1) {
+            free(paths[train]);
+        }
+
+        free(paths);
+
+        return 1;
+    }
+
+    self->paths = paths;
+
+    return 0;
+}
+
+size_t fleet_bytes(const struct fleet* self) {
+    return (size_t)self->blocks * (size_t)self->len * FLEET_LANES * sizeof(double);
+}
+
+// simulates every train with the given algo and step. the blocks are split
+// between the threads and each block is integrated on its own so the
+// results do not depend on the number of threads.
+int32_t fleet_run(struct fleet* self, int32_t algo, int32_t step, int32_t threads) {
+    const struct lut_kernel* kernel = get_lut_kernel(algo);
+    struct lut_interval_coeffs coeff;
+
+    lut_interval_coeffs(kernel, step, &coeff);
+
+    fleet_block_fn block_fn = fleet_block_kernel();
+    size_t block_len = (size_t)self->len * FLEET_LANES;
+
+#pragma omp parallel for num_threads(threads) schedule(static)
+    for (int32_t block = 0; block < self->blocks; block += 1) {
+        block_fn(
+            self->data + (size_t)block * block_len,
+            self->len,
+            &coeff,
+            self->velocity + (size_t)block * FLEET_LANES,
+            self->position + (size_t)block * FLEET_LANES
+        );
+    }
+
+    return 0;
+}
@@ -0,0 +1,45 @@
+#ifndef FLEET_H
+#define FLEET_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "summation.h"
+
+// the number of trains integrated together by each instruction of the fleet
+// kernels. a block of 8 doubles is a single avx512 vector, two avx2 vectors or
+// four neon vectors.
+#define FLEET_LANES 8
+
+// many profiles of the same length simulated together on the same timebase.
+// the profiles are stored as blocks of FLEET_LANES trains where entry sec of
+// every train in a block sits next to each other
+//
+//   data[(block * len + sec) * FLEET_LANES + lane]
+//
+// so a block is read as one contiguous stream of vectors and a thread works
+// through whole blocks. the last block is padded with zeros.
+struct fleet {
+    double* data;
+    int32_t trains;
+    int32_t len;
+    int32_t blocks;
+
+    // the profile each train was loaded from, only set by fleet_load_list
+    char** paths;
+
+    double* velocity;
+    double* position;
+};
+
+void fleet_init(struct fleet* self);
+void fleet_free(struct fleet* self);
+
+int32_t fleet_reserve(struct fleet* self, int32_t trains, int32_t len);
+int32_t fleet_set_train(struct fleet* self, int32_t train, struct lut_info* lut);
+int32_t fleet_load_list(struct fleet* self, const char* list_path);
+size_t fleet_bytes(const struct fleet* self);
+
+int32_t fleet_run(struct fleet* self, int32_t algo, int32_t step, int32_t threads);
+
+#endif
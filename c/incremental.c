@@ -0,0 +1,185 @@
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+
+#include "args.h"
+#include "context.h"
+#include "fenwick.h"
+#include "incremental.h"
+#include "kernels.h"
+#include "parallel.h"
+
+// recomputes I_i and J_i for the intervals [first, last)
+static void incremental_sim_intervals(struct incremental_sim* self, int32_t first, int32_t last) {
+    const double* accel = self->lut.lut;
+
+    self->kernel->integrate(&self->lut, first, last, self->step, self->integrals);
+
+    for (int32_t sec = first; sec < last; sec += 1) {
+        self->terms[sec] = lut_interval_position(
+            self->kernel,
+            self->step,
+            accel[sec - 1],
+            accel[sec],
+            0.0,
+            self->integrals[sec]
+        );
+    }
+}
+
+int32_t incremental_sim_init(struct incremental_sim* self, struct sim_args* args, struct lut_info* lut) {
+    self->kernel = get_lut_kernel(args->algo);
+    self->step = args->step;
+    self->lut.len = 0;
+    self->lut.lut = NULL;
+    self->integrals = NULL;
+    self->terms = NULL;
+    self->vel.tree = NULL;
+    self->moment.tree = NULL;
+    self->pos.tree = NULL;
+
+    if (lut->len < 2) {
+        fprintf(stderr, "acceleration profile must contain at least 2 entries\n");
+
+        return 1;
+    }
+
+    size_t len = (size_t)lut->len;
+
+    self->lut.lut = (double*)malloc(len * sizeof(double));
+    self->integrals = (double*)malloc(len * sizeof(double));
+    self->terms = (double*)malloc(len * sizeof(double));
+
+    if (self->lut.lut == NULL || self->integrals == NULL || self->terms == NULL) {
+        fprintf(stderr, "failed allocating incremental simulation. %s\n", strerror(errno));
+
+        incremental_sim_free(self);
+
+        return 1;
+    }
+
+    self->lut.len = lut->len;
+
+    memcpy(self->lut.lut, lut->lut, len * sizeof(double));
+
+    if (
+        fenwick_init(&self->vel, lut->len) != 0 ||
+        fenwick_init(&self->moment, lut->len) != 0 ||
+        fenwick_init(&self->pos, lut->len) != 0
+    ) {
+        incremental_sim_free(self);
+
+        return 1;
+    }
+
+    // the weight of the velocity at the start of an interval
+    self->q0 = lut_interval_position(self->kernel, self->step, 0.0, 0.0, 1.0, 1.0);
+
+    self->integrals[0] = 0.0;
+    self->terms[0] = 0.0;
+
+#pragma omp parallel num_threads(args->threads)
+    {
+        int32_t first;
+        int32_t last;
+
+        parallel_thread_range(1, self->lut.len, &first, &last);
+
+        incremental_sim_intervals(self, first, last);
+    }
+
+    fenwick_build(&self->vel, self->integrals);
+    fenwick_build(&self->pos, self->terms);
+
+    // the moments are written straight into the storage of their tree since
+    // it is built in place
+    double* moments = self->moment.tree + 1;
+
+    for (int32_t sec = 0; sec < self->lut.len; sec += 1) {
+        moments[sec] = (double)sec * self->integrals[sec];
+    }
+
+    fenwick_build(&self->moment, moments);
+
+    return 0;
+}
+
+void incremental_sim_free(struct incremental_sim* self) {
+    free(self->lut.lut);
+    free(self->integrals);
+    free(self->terms);
+
+    fenwick_free(&self->vel);
+    fenwick_free(&self->moment);
+    fenwick_free(&self->pos);
+
+    self->lut.lut = NULL;
+    self->lut.len = 0;
+    self->integrals = NULL;
+    self->terms = NULL;
+}
+
+// replaces count entries of the profile starting at first with the given
+// values. only the intervals on either side of a changed entry are integrated
+// again so the cost is O(k log n) for k changed entries.
+int32_t incremental_sim_update_range(struct incremental_sim* self, int32_t first, const double* values, int32_t count) {
+    if (count <= 0) {
+        return 0;
+    }
+
+    if (first < 0 || count > self->lut.len - first) {
+        fprintf(
+            stderr,
+            "attempted to update lut range that is out of bounds. range: %d..%d len: %d\n",
+            first,
+            first + count,
+            self->lut.len
+        );
+
+        return 1;
+    }
+
+    memcpy(self->lut.lut + first, values, (size_t)count * sizeof(double));
+
+    // entry k is the end of interval k and the start of interval k + 1
+    int32_t begin = first > 1 ? first : 1;
+    int32_t end = first + count + 1 < self->lut.len ? first + count + 1 : self->lut.len;
+
+    for (int32_t sec = begin; sec < end; sec += 1) {
+        double integral = self->integrals[sec];
+        double term = self->terms[sec];
+
+        incremental_sim_intervals(self, sec, sec + 1);
+
+        double delta = self->integrals[sec] - integral;
+
+        fenwick_add(&self->vel, sec, delta);
+        fenwick_add(&self->moment, sec, (double)sec * delta);
+        fenwick_add(&self->pos, sec, self->terms[sec] - term);
+    }
+
+    return 0;
+}
+
+// the velocity at the given index of the profile
+double incremental_sim_velocity(const struct incremental_sim* self, int32_t index) {
+    return fenwick_prefix(&self->vel, index);
+}
+
+// the position at the given index of the profile
+double incremental_sim_position(const struct incremental_sim* self, int32_t index) {
+    double vel = fenwick_prefix(&self->vel, index);
+    double moment = fenwick_prefix(&self->moment, index);
+
+    return self->q0 * ((double)index * vel - moment) + fenwick_prefix(&self->pos, index);
+}
+
+void incremental_sim_result(const struct incremental_sim* self, struct sim_result* result) {
+    int32_t last = self->lut.len - 1;
+
+    result->velocity = incremental_sim_velocity(self, last);
+    result->position = incremental_sim_position(self, last);
+}
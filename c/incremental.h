@@ -0,0 +1,60 @@
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+#include <stdint.h>
+
+#include "args.h"
+#include "context.h"
+#include "fenwick.h"
+#include "kernels.h"
+#include "summation.h"
+
+// the most entries a single edit of --check-incremental replaces
+#define INCREMENTAL_CHECK_RUN 64
+// the relative error after any edit at which --check-incremental fails
+#define INCREMENTAL_CHECK_TOLERANCE 1e-9
+
+// a simulation that can be updated when part of the acceleration profile
+// changes without integrating the whole profile again.
+//
+// every kernel integrates the position of interval i linearly in the velocity
+// at the start of the interval so it can be split into
+//
+//   P_i = q0 * V_(i - 1) + J_i
+//
+// where q0 only depends on the kernel and J_i only depends on the acceleration
+// at either end of the interval. with I_i as the integral of the acceleration
+// over interval i, the velocity and position at index k are
+//
+//   V_k = sum(I_j) for j <= k
+//   X_k = q0 * (k * V_k - sum(j * I_j)) + sum(J_j) for j <= k
+//
+// which are kept as three fenwick trees so changing k entries of the profile
+// only recomputes the integrals of the intervals touching them and each query
+// is O(log n).
+struct incremental_sim {
+    const struct lut_kernel* kernel;
+    int32_t step;
+    double q0;
+
+    // private copy of the profile since the loaded one may be read only
+    struct lut_info lut;
+    // I_i and J_i for each interval
+    double* integrals;
+    double* terms;
+
+    struct fenwick vel;
+    struct fenwick moment;
+    struct fenwick pos;
+};
+
+int32_t incremental_sim_init(struct incremental_sim* self, struct sim_args* args, struct lut_info* lut);
+void incremental_sim_free(struct incremental_sim* self);
+
+int32_t incremental_sim_update_range(struct incremental_sim* self, int32_t first, const double* values, int32_t count);
+
+double incremental_sim_velocity(const struct incremental_sim* self, int32_t index);
+double incremental_sim_position(const struct incremental_sim* self, int32_t index);
+void incremental_sim_result(const struct incremental_sim* self, struct sim_result* result);
+
+#endif
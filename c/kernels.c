@@ -0,0 +1,258 @@
+#include <stdint.h>
+#include <stdio.h>
+
+#include "args.h"
+#include "kernels.h"
+#include "simd.h"
+
+DEFINE_LUT_KERNELS(SCALAR_LUT_KERNELS, segment, )
+
+// the table is linear between each pair of points so the integral of an
+// interval is exactly the trapezoid (y0 + y1) / 2 and no sub steps are needed.
+static void exact_integrate(
+    struct lut_info* lut,
+    int32_t first,
+    int32_t last,
+    int32_t step,
+    double* out
+) {
+    (void)step;
+
+    lut_check_range(lut, first, last);
+
+    for (int32_t sec = first; sec < last; sec += 1) {
+        out[sec] = (lut->lut[sec - 1] + lut->lut[sec]) / 2.0;
+    }
+}
+
+static double exact_cumulate(
+    struct lut_info* lut,
+    int32_t first,
+    int32_t last,
+    int32_t step,
+    double start,
+    double* out
+) {
+    (void)step;
+
+    double total = start;
+
+    lut_check_range(lut, first, last);
+
+    for (int32_t sec = first; sec < last; sec += 1) {
+        total += (lut->lut[sec - 1] + lut->lut[sec]) / 2.0;
+
+        out[sec] = total;
+    }
+
+    return total;
+}
+
+static double exact_accumulate(
+    struct lut_info* lut,
+    int32_t first,
+    int32_t last,
+    int32_t step
+) {
+    (void)step;
+
+    double total = 0.0;
+
+    lut_check_range(lut, first, last);
+
+    for (int32_t sec = first; sec < last; sec += 1) {
+        total += (lut->lut[sec - 1] + lut->lut[sec]) / 2.0;
+    }
+
+    return total;
+}
+
+// with a(t) = a0 + t * (a1 - a0) inside of an interval the velocity is the
+// quadratic v(t) = v0 + a0 * t + (a1 - a0) * t^2 / 2 and integrating that over
+// [0, 1] gives v0 + (2 * a0 + a1) / 6
+static double exact_position(
+    struct lut_info* accel,
+    struct lut_info* vel,
+    int32_t first,
+    int32_t last,
+    int32_t step
+) {
+    (void)step;
+
+    double total = 0.0;
+
+    lut_check_range(accel, first, last);
+    lut_check_range(vel, first, last);
+
+    for (int32_t sec = first; sec < last; sec += 1) {
+        total += vel->lut[sec - 1] + (2.0 * accel->lut[sec - 1] + accel->lut[sec]) / 6.0;
+    }
+
+    return total;
+}
+
+static void exact_fused(
+    struct lut_info* lut,
+    int32_t first,
+    int32_t last,
+    int32_t step,
+    struct fused_state* state
+) {
+    (void)step;
+
+    double vel = state->vel;
+    double pos = state->pos;
+
+    lut_check_range(lut, first, last);
+
+    for (int32_t sec = first; sec < last; sec += 1) {
+        double a0 = lut->lut[sec - 1];
+        double a1 = lut->lut[sec];
+
+        pos += vel + (2.0 * a0 + a1) / 6.0;
+        vel += (a0 + a1) / 2.0;
+    }
+
+    state->vel = vel;
+    state->pos = pos;
+}
+
+static const struct lut_kernel EXACT_LUT_KERNEL = {
+    "exact",
+    exact_integrate,
+    exact_cumulate,
+    exact_accumulate,
+    exact_position,
+    exact_fused
+};
+
+// the integral of the acceleration over a single interval with the given
+// acceleration at either end of it
+double lut_interval_integral(const struct lut_kernel* kernel, int32_t step, double a0, double a1) {
+    double accel_data[2] = { a0, a1 };
+    struct lut_info accel;
+
+    accel.len = 2;
+    accel.lut = accel_data;
+
+    return kernel->accumulate(&accel, 1, 2, step);
+}
+
+// the position over a single interval given the acceleration and velocity at
+// either end of it
+double lut_interval_position(
+    const struct lut_kernel* kernel,
+    int32_t step,
+    double a0,
+    double a1,
+    double v0,
+    double v1
+) {
+    double accel_data[2] = { a0, a1 };
+    double vel_data[2] = { v0, v1 };
+    struct lut_info accel;
+    struct lut_info vel;
+
+    accel.len = 2;
+    accel.lut = accel_data;
+    vel.len = 2;
+    vel.lut = vel_data;
+
+    return kernel->position(&accel, &vel, 1, 2, step);
+}
+
+// finds the coefficients by running the kernel over single intervals so using
+// them gives what the kernel would over the whole table up to rounding
+void lut_interval_coeffs(const struct lut_kernel* kernel, int32_t step, struct lut_interval_coeffs* out) {
+    out->i0 = lut_interval_integral(kernel, step, 1.0, 1.0);
+    out->i1 = lut_interval_integral(kernel, step, 0.0, 1.0);
+    out->q0 = lut_interval_position(kernel, step, 0.0, 0.0, 1.0, 1.0);
+    out->j0 = lut_interval_position(kernel, step, 1.0, 1.0, 0.0, out->i0);
+    out->j1 = lut_interval_position(kernel, step, 0.0, 1.0, 0.0, out->i1);
+}
+
+static const struct lut_kernel* active_kernels = NULL;
+static int32_t active_isa = ISA_SCALAR;
+
+const char* lut_kernel_isa_name(int32_t isa) {
+    switch (isa) {
+    case ISA_SCALAR:
+        return "scalar";
+    case ISA_AVX2:
+        return "avx2";
+    case ISA_AVX512:
+        return "avx512";
+    case ISA_NEON:
+        return "neon";
+    default:
+        return "unknown";
+    }
+}
+
+// picks the kernels for the requested instruction set. ISA_AUTO will pick the
+// widest one that the cpu supports and fall back to the scalar kernels
+int32_t lut_kernel_select(int32_t isa) {
+    if (isa == ISA_AUTO) {
+        const int32_t preferred[] = { ISA_AVX512, ISA_AVX2, ISA_NEON };
+
+        for (size_t index = 0; index < sizeof(preferred) / sizeof(preferred[0]); index += 1) {
+            const struct lut_kernel* found = get_simd_kernels(preferred[index]);
+
+            if (found != NULL) {
+                active_kernels = found;
+                active_isa = preferred[index];
+
+                return 0;
+            }
+        }
+
+        active_kernels = SCALAR_LUT_KERNELS;
+        active_isa = ISA_SCALAR;
+
+        return 0;
+    }
+
+    if (isa == ISA_SCALAR) {
+        active_kernels = SCALAR_LUT_KERNELS;
+        active_isa = ISA_SCALAR;
+
+        return 0;
+    }
+
+    const struct lut_kernel* found = get_simd_kernels(isa);
+
+    if (found == NULL) {
+        fprintf(stderr, "instruction set is not supported. %s\n", lut_kernel_isa_name(isa));
+
+        return 1;
+    }
+
+    active_kernels = found;
+    active_isa = isa;
+
+    return 0;
+}
+
+int32_t lut_kernel_isa() {
+    if (active_kernels == NULL) {
+        lut_kernel_select(ISA_AUTO);
+    }
+
+    return active_isa;
+}
+
+const struct lut_kernel* get_lut_kernel(int32_t algo) {
+    if (active_kernels == NULL) {
+        lut_kernel_select(ISA_AUTO);
+    }
+
+    if (algo == EXACT) {
+        return &EXACT_LUT_KERNEL;
+    }
+
+    if (algo < 0 || algo >= LUT_KERNEL_COUNT) {
+        return &active_kernels[LEFT_RIEMANN];
+    }
+
+    return &active_kernels[algo];
+}
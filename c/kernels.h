@@ -0,0 +1,354 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "summation.h"
+
+// specialized versions of the summation functions that call the interpolator
+// directly instead of through a summation_cb. the summation bodies are
+// generated by the macros below for a given context type and interpolator so
+// the compiler is able to inline the whole inner loop. the generic callback
+// versions in summation.h are still available for custom functions.
+
+// writes the integral of each interval [sec - 1, sec] for sec in [first, last)
+// into out[sec]
+typedef void (*lut_integrate)(struct lut_info* lut, int32_t first, int32_t last, int32_t step, double* out);
+// same as lut_integrate but writes the running total starting from the given
+// value into out[sec] and returns the final total
+typedef double (*lut_cumulate)(struct lut_info* lut, int32_t first, int32_t last, int32_t step, double start, double* out);
+// returns the sum of the integrals of each interval [sec - 1, sec] for sec in
+// [first, last)
+typedef double (*lut_accumulate)(struct lut_info* lut, int32_t first, int32_t last, int32_t step);
+// returns the change in position over the intervals [sec - 1, sec] for sec in
+// [first, last) given the acceleration and the cumulative velocity tables.
+// the summation kernels only need the velocity table but the exact kernel
+// integrates the piecewise quadratic velocity from the acceleration.
+typedef double (*lut_position)(struct lut_info* accel, struct lut_info* vel, int32_t first, int32_t last, int32_t step);
+
+// the velocity and position carried between intervals when both are computed
+// in a single pass
+struct fused_state {
+    double vel;
+    double pos;
+};
+
+// integrates velocity and position together over the intervals [sec - 1, sec]
+// for sec in [first, last) starting from the given state. only the velocity at
+// either end of the current interval is kept so no velocity table is needed.
+typedef void (*lut_fused)(struct lut_info* accel, int32_t first, int32_t last, int32_t step, struct fused_state* state);
+
+struct lut_kernel {
+    const char* name;
+    lut_integrate integrate;
+    lut_cumulate cumulate;
+    lut_accumulate accumulate;
+    lut_position position;
+    lut_fused fused;
+};
+
+// the number of summation algorithms that have a kernel for each instruction
+// set. the exact kernel does not depend on the instruction set.
+#define LUT_KERNEL_COUNT 5
+
+// every kernel is linear in the acceleration and the
+// velocity, so over an interval where the acceleration goes from a0 to
+// a0 + slope starting at velocity v it gains
+//
+//   velocity  i0 * a0 + i1 * slope
+//   position  q0 * v + j0 * a0 + j1 * slope
+struct lut_interval_coeffs {
+    // the integral of a constant 1 and of the ramp from 0 to 1
+    double i0;
+    double i1;
+    // the position gained from the velocity at the start of an interval
+    double q0;
+    // the position gained from the acceleration inside of an interval
+    double j0;
+    double j1;
+};
+
+int32_t lut_kernel_select(int32_t isa);
+
+double lut_interval_integral(const struct lut_kernel* kernel, int32_t step, double a0, double a1);
+double lut_interval_position(
+    const struct lut_kernel* kernel,
+    int32_t step,
+    double a0,
+    double a1,
+    double v0,
+    double v1
+);
+void lut_interval_coeffs(const struct lut_kernel* kernel, int32_t step, struct lut_interval_coeffs* out);
+int32_t lut_kernel_isa();
+const char* lut_kernel_isa_name(int32_t isa);
+const struct lut_kernel* get_lut_kernel(int32_t algo);
+
+// a single linear piece of the table between index and index + 1 in local
+// coordinates where t = x - index is in [0, 1]. the slope is computed once
+// per interval so evaluating the piece is a single multiply add.
+struct lut_segment {
+    double y0;
+    double slope;
+};
+
+// validates once that every interval [sec - 1, sec] for sec in [first, last)
+// is inside of the table so the intervals can be read without any checks
+static inline void lut_check_range(const struct lut_info* lut, int32_t first, int32_t last) {
+    if (__builtin_expect(first < last && (first < 1 || last > lut->len), 0)) {
+        fprintf(
+            stderr,
+            "attempted to access lut range that is out of bounds. range: %d..%d len: %d\n",
+            first - 1,
+            last,
+            lut->len
+        );
+
+        exit(EXIT_FAILURE);
+    }
+}
+
+// retrieves the segment for the interval [sec - 1, sec] without any checks
+static inline struct lut_segment lut_get_segment(const struct lut_info* lut, int32_t sec) {
+    struct lut_segment seg;
+    seg.y0 = lut->lut[sec - 1];
+    seg.slope = lut->lut[sec] - seg.y0;
+
+    return seg;
+}
+
+// linear interpolation inside of a segment, y = y0 + t * (y1 - y0)
+static inline double segment_interpolate(const struct lut_segment* seg, double t) {
+    return seg->y0 + t * seg->slope;
+}
+
+#define DEFINE_LEFT_RIEMANN_T(name, ctx_type, interp, real)                  \
+static inline real name(ctx_type ctx, real lower, real upper, int32_t iterations) { \
+    real step = (upper - lower) / (real)iterations;                          \
+    real sum = (real)0.0;                                                    \
+                                                                             \
+    for (int32_t iter = 0; iter < iterations; iter += 1) {                   \
+        sum += interp(ctx, lower + (real)iter * step);                       \
+    }                                                                        \
+                                                                             \
+    return step * sum;                                                       \
+}
+
+#define DEFINE_MID_RIEMANN_T(name, ctx_type, interp, real)                   \
+static inline real name(ctx_type ctx, real lower, real upper, int32_t iterations) { \
+    real step = (upper - lower) / (real)iterations;                          \
+    real half_step = step / (real)2.0;                                       \
+    real sum = (real)0.0;                                                    \
+                                                                             \
+    for (int32_t iter = 0; iter < iterations; iter += 1) {                   \
+        sum += interp(ctx, (lower + (real)iter * step) + half_step);         \
+    }                                                                        \
+                                                                             \
+    return step * sum;                                                       \
+}
+
+#define DEFINE_RIGHT_RIEMANN_T(name, ctx_type, interp, real)                 \
+static inline real name(ctx_type ctx, real lower, real upper, int32_t iterations) { \
+    real step = (upper - lower) / (real)iterations;                          \
+    real sum = (real)0.0;                                                    \
+                                                                             \
+    for (int32_t iter = 0; iter < iterations; iter += 1) {                   \
+        sum += interp(ctx, lower + (real)(iter + 1) * step);                 \
+    }                                                                        \
+                                                                             \
+    return step * sum;                                                       \
+}
+
+#define DEFINE_TRAPEZOIDAL_T(name, ctx_type, interp, real)                   \
+static inline real name(ctx_type ctx, real lower, real upper, int32_t iterations) { \
+    real step = (upper - lower) / (real)iterations;                          \
+    real sum = (interp(ctx, lower) + interp(ctx, upper)) / (real)2.0;        \
+                                                                             \
+    for (int32_t iter = 1; iter < iterations; iter += 1) {                   \
+        sum += interp(ctx, lower + (real)iter * step);                       \
+    }                                                                        \
+                                                                             \
+    return step * sum;                                                       \
+}
+
+#define DEFINE_SIMPSONS_T(name, ctx_type, interp, real)                      \
+static inline real name(ctx_type ctx, real lower, real upper, int32_t iterations) { \
+    real step = (upper - lower) / (real)iterations;                          \
+    real sum = interp(ctx, lower);                                           \
+                                                                             \
+    for (int32_t iter = 1; iter < iterations; iter += 1) {                   \
+        /* odd points are weighted by 4 and even points by 2 */              \
+        real weight = (real)(2 + 2 * (iter & 1));                            \
+                                                                             \
+        sum += weight * interp(ctx, lower + (real)iter * step);              \
+    }                                                                        \
+                                                                             \
+    if (iterations > 0) {                                                    \
+        sum += interp(ctx, lower + (real)iterations * step);                 \
+    }                                                                        \
+                                                                             \
+    return step * sum / (real)3.0;                                           \
+}
+
+// the summations in double precision. the _T versions above take the type
+// used for evaluating and summing the points so the same rules can be
+// generated for other precisions.
+#define DEFINE_LEFT_RIEMANN(name, ctx_type, interp) DEFINE_LEFT_RIEMANN_T(name, ctx_type, interp, double)
+#define DEFINE_MID_RIEMANN(name, ctx_type, interp) DEFINE_MID_RIEMANN_T(name, ctx_type, interp, double)
+#define DEFINE_RIGHT_RIEMANN(name, ctx_type, interp) DEFINE_RIGHT_RIEMANN_T(name, ctx_type, interp, double)
+#define DEFINE_TRAPEZOIDAL(name, ctx_type, interp) DEFINE_TRAPEZOIDAL_T(name, ctx_type, interp, double)
+#define DEFINE_SIMPSONS(name, ctx_type, interp) DEFINE_SIMPSONS_T(name, ctx_type, interp, double)
+
+// generates all summation functions for the given interpolator with the
+// names <prefix>_left_riemann, <prefix>_mid_riemann, etc.
+#define DEFINE_SUMMATIONS_T(prefix, ctx_type, interp, real)                  \
+    DEFINE_LEFT_RIEMANN_T(prefix##_left_riemann, ctx_type, interp, real)     \
+    DEFINE_MID_RIEMANN_T(prefix##_mid_riemann, ctx_type, interp, real)       \
+    DEFINE_RIGHT_RIEMANN_T(prefix##_right_riemann, ctx_type, interp, real)   \
+    DEFINE_TRAPEZOIDAL_T(prefix##_trapezoidal, ctx_type, interp, real)       \
+    DEFINE_SIMPSONS_T(prefix##_simpsons, ctx_type, interp, real)
+
+#define DEFINE_SUMMATIONS(prefix, ctx_type, interp)                          \
+    DEFINE_SUMMATIONS_T(prefix, ctx_type, interp, double)
+
+// each summation is evaluated over the local coordinates [0, 1] of a
+// single segment
+DEFINE_SUMMATIONS(segment, const struct lut_segment*, segment_interpolate)
+
+// generates the interval range functions for a given segment summation so
+// the summation and interpolator are inlined into the loop over the table.
+// the range is validated once up front and each interval is then integrated
+// over its segment without any further checks. the attr is used to compile
+// the functions for a specific instruction set.
+#define DEFINE_LUT_KERNEL_ATTR(sum_fn, attr)                                 \
+attr static void sum_fn##_integrate(                                         \
+    struct lut_info* lut,                                                    \
+    int32_t first,                                                           \
+    int32_t last,                                                            \
+    int32_t step,                                                            \
+    double* out                                                              \
+) {                                                                          \
+    lut_check_range(lut, first, last);                                       \
+                                                                             \
+    for (int32_t sec = first; sec < last; sec += 1) {                        \
+        struct lut_segment seg = lut_get_segment(lut, sec);                  \
+                                                                             \
+        out[sec] = sum_fn(&seg, 0.0, 1.0, step);                             \
+    }                                                                        \
+}                                                                            \
+                                                                             \
+attr static double sum_fn##_cumulate(                                        \
+    struct lut_info* lut,                                                    \
+    int32_t first,                                                           \
+    int32_t last,                                                            \
+    int32_t step,                                                            \
+    double start,                                                            \
+    double* out                                                              \
+) {                                                                          \
+    double total = start;                                                    \
+                                                                             \
+    lut_check_range(lut, first, last);                                       \
+                                                                             \
+    for (int32_t sec = first; sec < last; sec += 1) {                        \
+        struct lut_segment seg = lut_get_segment(lut, sec);                  \
+                                                                             \
+        total += sum_fn(&seg, 0.0, 1.0, step);                               \
+                                                                             \
+        out[sec] = total;                                                    \
+    }                                                                        \
+                                                                             \
+    return total;                                                            \
+}                                                                            \
+                                                                             \
+attr static double sum_fn##_accumulate(                                      \
+    struct lut_info* lut,                                                    \
+    int32_t first,                                                           \
+    int32_t last,                                                            \
+    int32_t step                                                             \
+) {                                                                          \
+    double total = 0.0;                                                      \
+                                                                             \
+    lut_check_range(lut, first, last);                                       \
+                                                                             \
+    for (int32_t sec = first; sec < last; sec += 1) {                        \
+        struct lut_segment seg = lut_get_segment(lut, sec);                  \
+                                                                             \
+        total += sum_fn(&seg, 0.0, 1.0, step);                               \
+    }                                                                        \
+                                                                             \
+    return total;                                                            \
+}                                                                            \
+                                                                             \
+attr static double sum_fn##_position(                                        \
+    struct lut_info* accel,                                                  \
+    struct lut_info* vel,                                                    \
+    int32_t first,                                                           \
+    int32_t last,                                                            \
+    int32_t step                                                             \
+) {                                                                          \
+    (void)accel;                                                             \
+                                                                             \
+    return sum_fn##_accumulate(vel, first, last, step);                      \
+}                                                                            \
+                                                                             \
+attr static void sum_fn##_fused(                                             \
+    struct lut_info* lut,                                                    \
+    int32_t first,                                                           \
+    int32_t last,                                                            \
+    int32_t step,                                                            \
+    struct fused_state* state                                                \
+) {                                                                          \
+    double vel = state->vel;                                                 \
+    double pos = state->pos;                                                 \
+                                                                             \
+    lut_check_range(lut, first, last);                                       \
+                                                                             \
+    for (int32_t sec = first; sec < last; sec += 1) {                        \
+        struct lut_segment seg = lut_get_segment(lut, sec);                  \
+        double next = vel + sum_fn(&seg, 0.0, 1.0, step);                    \
+                                                                             \
+        /* the same segment the two pass version reads from the table */     \
+        struct lut_segment vel_seg;                                          \
+        vel_seg.y0 = vel;                                                    \
+        vel_seg.slope = next - vel;                                          \
+                                                                             \
+        pos += sum_fn(&vel_seg, 0.0, 1.0, step);                             \
+        vel = next;                                                          \
+    }                                                                        \
+                                                                             \
+    state->vel = vel;                                                        \
+    state->pos = pos;                                                        \
+}
+
+#define DEFINE_LUT_KERNEL(sum_fn) DEFINE_LUT_KERNEL_ATTR(sum_fn, )
+
+#define LUT_KERNEL_ENTRY(label, sum_fn) \
+    {                                                                        \
+        label,                                                               \
+        sum_fn##_integrate,                                                  \
+        sum_fn##_cumulate,                                                   \
+        sum_fn##_accumulate,                                                 \
+        sum_fn##_position,                                                   \
+        sum_fn##_fused                                                       \
+    }
+
+// generates the range functions for all of the <prefix>_<algo> summations and
+// a kernel table of them indexed by enum ALGO
+#define DEFINE_LUT_KERNELS(table, prefix, attr)                              \
+    DEFINE_LUT_KERNEL_ATTR(prefix##_left_riemann, attr)                      \
+    DEFINE_LUT_KERNEL_ATTR(prefix##_mid_riemann, attr)                       \
+    DEFINE_LUT_KERNEL_ATTR(prefix##_right_riemann, attr)                     \
+    DEFINE_LUT_KERNEL_ATTR(prefix##_trapezoidal, attr)                       \
+    DEFINE_LUT_KERNEL_ATTR(prefix##_simpsons, attr)                          \
+                                                                             \
+    static const struct lut_kernel table[LUT_KERNEL_COUNT] = {               \
+        LUT_KERNEL_ENTRY("left-riemann", prefix##_left_riemann),             \
+        LUT_KERNEL_ENTRY("mid-riemann", prefix##_mid_riemann),               \
+        LUT_KERNEL_ENTRY("right-riemann", prefix##_right_riemann),           \
+        LUT_KERNEL_ENTRY("trapezoidal", prefix##_trapezoidal),               \
+        LUT_KERNEL_ENTRY("simpsons", prefix##_simpsons),                     \
+    };
+
+#endif
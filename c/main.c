@@ -0,0 +1,191 @@
+#include <stdint.h>
+#include <stdio.h>
+
+#include "args.h"
+#include "batch.h"
+#include "kernels.h"
+#include "profile.h"
+#include "server.h"
+#include "sim.h"
+#include "table_lookup.h"
+
+int main(int argc, char** argv) {
+    struct app_args args;
+
+    if (app_args_init(&args, argc, argv) != 0) {
+        return 1;
+    }
+
+    if (args.batch_path != NULL) {
+        if (lut_kernel_select(args.sim.isa) != 0) {
+            return 1;
+        }
+
+        struct batch batch;
+        batch_init(&batch);
+
+        int32_t result = batch_load_manifest(&batch, args.batch_path, &args.sim);
+
+        if (result == 0) {
+            result = batch_run(&batch, &args.sim, args.format);
+        }
+
+        batch_free(&batch);
+
+        return result;
+    }
+
+    if (args.serve_path != NULL) {
+        if (lut_kernel_select(args.sim.isa) != 0) {
+            return 1;
+        }
+
+        return server_run(&args.sim, args.serve_path, (size_t)args.cache_mb * 1024 * 1024);
+    }
+
+    if (args.index_path != NULL) {
+        return sim_run_index_queries(args.index_path);
+    }
+
+    if (args.fleet_path != NULL) {
+        if (lut_kernel_select(args.sim.isa) != 0) {
+            return 1;
+        }
+
+        return sim_run_fleet(&args.sim, args.fleet_path, args.format);
+    }
+
+    if (args.stream) {
+        if (args.file_path == NULL) {
+            fprintf(stderr, "--stream requires a csv profile to read\n");
+
+            return 1;
+        }
+
+        if (lut_kernel_select(args.sim.isa) != 0) {
+            return 1;
+        }
+
+        return sim_run_stream(&args.sim, args.file_path);
+    }
+
+    struct profile accel_profile;
+    profile_init(&accel_profile);
+
+    if (args.file_path != NULL) {
+        if (profile_load(args.file_path, &accel_profile) != 0) {
+            return 1;
+        }
+
+        profile_print_load(&accel_profile);
+    } else {
+        // fall back to the compiled in table when no file is provided
+        accel_profile.lut.len = TABLE_SIZE;
+        accel_profile.lut.lut = ACCELERATION_DATA;
+    }
+
+    struct lut_info accel_lut = accel_profile.lut;
+
+    if (args.convert_path != NULL) {
+        double sample_rate = args.sample_rate > 0.0
+            ? args.sample_rate
+            : accel_profile.sample_rate;
+
+        int32_t result = profile_write_binary(args.convert_path, &accel_lut, sample_rate);
+
+        profile_free(&accel_profile);
+
+        return result;
+    }
+
+    if (lut_kernel_select(args.sim.isa) != 0) {
+        profile_free(&accel_profile);
+
+        return 1;
+    }
+
+    if (accel_lut.len < 2) {
+        fprintf(stderr, "acceleration profile must contain at least 2 entries\n");
+
+        profile_free(&accel_profile);
+
+        return 1;
+    }
+
+    if (args.sweep_steps_len > 0) {
+        int32_t result = sim_run_sweep(
+            &args.sim,
+            &accel_lut,
+            args.sweep_algos,
+            args.sweep_algos_len,
+            args.sweep_steps,
+            args.sweep_steps_len,
+            args.format
+        );
+
+        profile_free(&accel_profile);
+
+        return result;
+    }
+
+    if (args.index_out_path != NULL) {
+        int32_t result = sim_run_index_build(&args.sim, &accel_lut, args.index_out_path);
+
+        profile_free(&accel_profile);
+
+        return result;
+    }
+
+    if (args.trajectory_path != NULL) {
+        int32_t result = sim_run_trajectory(
+            &args.sim,
+            &accel_lut,
+            args.trajectory_path,
+            args.trajectory_format
+        );
+
+        profile_free(&accel_profile);
+
+        return result;
+    }
+
+    if (args.check_edits > 0) {
+        int32_t result = sim_run_incremental_check(&args.sim, &accel_lut, args.check_edits);
+
+        profile_free(&accel_profile);
+
+        return result;
+    }
+
+    if (args.precision != PRECISION_DOUBLE) {
+        int32_t result = sim_run_precision(&args.sim, &accel_lut, args.precision);
+
+        profile_free(&accel_profile);
+
+        return result;
+    }
+
+    if (args.compress) {
+        int32_t result = sim_run_compressed(&args.sim, &accel_lut, args.compress_tolerance);
+
+        profile_free(&accel_profile);
+
+        return result;
+    }
+
+    if (args.offload) {
+        int32_t result = sim_run_offload(&args.sim, &accel_lut);
+
+        profile_free(&accel_profile);
+
+        return result;
+    }
+
+    int32_t result = args.sim.threads == 1
+        ? sim_run_serial(&args.sim, &accel_lut)
+        : sim_run_openmp(&args.sim, &accel_lut);
+
+    profile_free(&accel_profile);
+
+    return result;
+}
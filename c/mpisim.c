@@ -0,0 +1,476 @@
+// distributed runner for profiles and batches that are too large for a single
+// node. it takes the same arguments as sim and is started with mpirun.
+//
+// a single profile is split into one contiguous range of intervals per rank.
+// every rank runs the regular context over its own range starting from zero,
+// the velocity each range starts at is the exclusive scan of the velocities
+// gained by the ranks before it, and starting at velocity v only adds
+// v * weight * n to the position of a range of n intervals, the same join the
+// fused runners use between threads. binary profiles are memory mapped so a
+// rank only reads the pages of its own range.
+//
+// a batch is farmed out a job at a time. the index of the next job lives in a
+// window on rank 0 and is taken with an atomic fetch and add so ranks pull
+// more work as they finish instead of splitting the jobs up front.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <mpi.h>
+
+#include "args.h"
+#include "batch.h"
+#include "context.h"
+#include "kernels.h"
+#include "profile.h"
+#include "table_lookup.h"
+#include "ts.h"
+
+// the values of a job sent back to rank 0 once the batch is done
+enum JOB_REPORT {
+    JOB_REPORT_LEN = 0,
+    JOB_REPORT_VELOCITY = 1,
+    JOB_REPORT_POSITION = 2,
+    JOB_REPORT_SECS = 3,
+    JOB_REPORT_NSECS = 4,
+    JOB_REPORT_FAILED = 5,
+    JOB_REPORT_COUNT = 6
+};
+
+// every rank has to agree on a failure, otherwise the ranks that are still
+// going would wait on the next collective forever
+static int32_t all_ok(int32_t ok) {
+    int32_t all = 0;
+
+    MPI_Allreduce(&ok, &all, 1, MPI_INT32_T, MPI_MIN, MPI_COMM_WORLD);
+
+    return all;
+}
+
+// the intervals [first, last) of [begin, end) that belong to the given rank.
+// the same split parallel_thread_range does for the threads of a parallel
+// region.
+static void rank_range(int32_t begin, int32_t end, int32_t rank, int32_t ranks, int32_t* first, int32_t* last) {
+    int32_t total = end - begin;
+    int32_t chunk = total / ranks;
+    int32_t extra = total % ranks;
+
+    *first = begin + rank * chunk + (rank < extra ? rank : extra);
+    *last = *first + chunk + (rank < extra ? 1 : 0);
+}
+
+// gathers the timing of every rank on rank 0 and prints each of them followed
+// by all of them merged
+static void print_rank_timings(const char* name, struct timing* timing, int32_t rank, int32_t ranks) {
+    struct timing* timings = NULL;
+
+    if (rank == 0) {
+        timings = (struct timing*)malloc((size_t)ranks * sizeof(struct timing));
+
+        if (timings == NULL) {
+            fprintf(stderr, "failed allocating rank timings\n");
+
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+    }
+
+    MPI_Gather(
+        timing,
+        (int)sizeof(struct timing),
+        MPI_BYTE,
+        timings,
+        (int)sizeof(struct timing),
+        MPI_BYTE,
+        0,
+        MPI_COMM_WORLD
+    );
+
+    if (rank != 0) {
+        return;
+    }
+
+    struct timing merged;
+    timing_init(&merged);
+
+    for (int32_t index = 0; index < ranks; index += 1) {
+        struct timing* given = &timings[index];
+        struct timespec avg = {0, 0};
+
+        if (given->count > 0 && timespec_div(&given->total, given->count, &avg) != 0) {
+            printf("bad nanos calculated\n");
+        }
+
+        printf(
+            "%s rank %d: count: %u avg: %ld.%.9ld max: %ld.%.9ld tot: %ld.%.9ld\n",
+            name,
+            index,
+            given->count,
+            avg.tv_sec,
+            avg.tv_nsec,
+            given->max.tv_sec,
+            given->max.tv_nsec,
+            given->total.tv_sec,
+            given->total.tv_nsec
+        );
+
+        timing_merge(&merged, given);
+    }
+
+    printf("%s merged:\n", name);
+    timing_print(&merged);
+
+    free(timings);
+}
+
+// runs the profile split across every rank for the requested number of
+// iterations. the compute timings only cover the local range and the
+// communication timings cover the scan and the reduction after it.
+static int32_t run_distributed(struct sim_args* args, struct lut_info* lut, int32_t rank, int32_t ranks) {
+    int32_t first;
+    int32_t last;
+
+    rank_range(1, lut->len, rank, ranks, &first, &last);
+
+    // the range [first, last) only needs the entries first - 1 through
+    // last - 1, which are intervals [1, len) of the local view
+    int32_t intervals = last - first;
+    struct lut_info local;
+    local.lut = lut->lut + (first - 1);
+    local.len = intervals + 1;
+
+    struct sim_context context;
+
+    if (!all_ok(sim_context_init(&context, args, local.len) == 0)) {
+        sim_context_free(&context);
+
+        return 1;
+    }
+
+    // starting a range at velocity v instead of zero adds v * weight to the
+    // position of each of its intervals
+    struct lut_interval_coeffs coeffs;
+
+    lut_interval_coeffs(get_lut_kernel(args->algo), args->step, &coeffs);
+
+    double weight = coeffs.q0;
+
+    struct timing compute;
+    struct timing comm;
+    struct sim_result result = {0.0, 0.0};
+    double totals[2] = {0.0, 0.0};
+    int32_t ok = 1;
+
+    timing_init(&compute);
+    timing_init(&comm);
+
+    for (int32_t c = 0; c < args->iterations; c += 1) {
+        struct timespec start;
+        struct timespec end;
+        struct timespec diff;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+
+        if (intervals > 0 && sim_context_run(&context, &local, &result) != 0) {
+            ok = 0;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        timespec_diff(&start, &end, &diff);
+        timing_update(&compute, &diff);
+
+        start = end;
+
+        double offset = 0.0;
+
+        MPI_Exscan(&result.velocity, &offset, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+
+        // the receive buffer of rank 0 is left undefined by the scan
+        if (rank == 0) {
+            offset = 0.0;
+        }
+
+        double state[2] = {
+            result.velocity,
+            result.position + offset * weight * (double)intervals
+        };
+
+        MPI_Reduce(state, totals, 2, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        timespec_diff(&start, &end, &diff);
+        timing_update(&comm, &diff);
+    }
+
+    sim_context_free(&context);
+
+    if (!all_ok(ok)) {
+        return 1;
+    }
+
+    if (rank == 0) {
+        printf("velocity: %.15lf\n", totals[0]);
+        printf("position: %.15lf\n", totals[1]);
+        printf("ranks: %d entries: %d\n", ranks, lut->len);
+    }
+
+    print_rank_timings("compute", &compute, rank, ranks);
+    print_rank_timings("comm", &comm, rank, ranks);
+
+    return 0;
+}
+
+// runs every job of the batch on whichever rank asks for it next. jobs are
+// handed out in manifest order so jobs of the same profile that are listed
+// together reuse the profile a rank already has loaded. the results are
+// printed by rank 0 in manifest order once every job is done.
+static int32_t run_farm(struct batch* batch, struct sim_args* args, int32_t format, int32_t rank, int32_t ranks) {
+    int32_t* next = NULL;
+    MPI_Win win;
+
+    MPI_Win_allocate(
+        rank == 0 ? (MPI_Aint)sizeof(int32_t) : 0,
+        (int)sizeof(int32_t),
+        MPI_INFO_NULL,
+        MPI_COMM_WORLD,
+        &next,
+        &win
+    );
+
+    if (rank == 0) {
+        MPI_Win_lock(MPI_LOCK_EXCLUSIVE, 0, 0, win);
+        *next = 0;
+        MPI_Win_unlock(0, win);
+    }
+
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    // the jobs run one at a time on each rank with the threads of the rank
+    // and the fused pass so the context does not need a velocity table
+    struct sim_args job_args = *args;
+    job_args.fused = 1;
+
+    struct sim_context context;
+    double* report = (double*)calloc((size_t)batch->len * JOB_REPORT_COUNT, sizeof(double));
+    int32_t ok = sim_context_init(&context, &job_args, 0) == 0;
+
+    if (report == NULL) {
+        fprintf(stderr, "failed allocating batch report\n");
+
+        ok = 0;
+    }
+
+    if (!all_ok(ok)) {
+        sim_context_free(&context);
+        free(report);
+        MPI_Win_free(&win);
+
+        return 1;
+    }
+
+    struct profile profile;
+    const char* loaded_path = NULL;
+    int32_t loaded = 0;
+    struct timing timing;
+    int32_t one = 1;
+
+    profile_init(&profile);
+    timing_init(&timing);
+
+    while (1) {
+        int32_t index = 0;
+
+        MPI_Win_lock(MPI_LOCK_SHARED, 0, 0, win);
+        MPI_Fetch_and_op(&one, &index, MPI_INT32_T, 0, 0, MPI_SUM, win);
+        MPI_Win_unlock(0, win);
+
+        if (index >= batch->len) {
+            break;
+        }
+
+        struct batch_job* job = &batch->jobs[index];
+
+        if (loaded_path == NULL || strcmp(loaded_path, job->file_path) != 0) {
+            profile_free(&profile);
+
+            loaded_path = job->file_path;
+            loaded = profile_load(job->file_path, &profile) == 0;
+
+            if (loaded && profile.lut.len < 2) {
+                fprintf(stderr, "acceleration profile must contain at least 2 entries. %s\n", job->file_path);
+
+                profile_free(&profile);
+
+                loaded = 0;
+            }
+        }
+
+        if (loaded) {
+            batch_job_run(job, &context, &profile.lut);
+        } else {
+            job->failed = 1;
+        }
+
+        if (!job->failed) {
+            timing_update(&timing, &job->elapsed);
+        }
+
+        double* row = report + (size_t)index * JOB_REPORT_COUNT;
+        row[JOB_REPORT_LEN] = (double)job->len;
+        row[JOB_REPORT_VELOCITY] = job->velocity;
+        row[JOB_REPORT_POSITION] = job->position;
+        row[JOB_REPORT_SECS] = (double)job->elapsed.tv_sec;
+        row[JOB_REPORT_NSECS] = (double)job->elapsed.tv_nsec;
+        row[JOB_REPORT_FAILED] = (double)job->failed;
+    }
+
+    profile_free(&profile);
+    sim_context_free(&context);
+
+    // every job was run by exactly one rank and is zero everywhere else
+    MPI_Reduce(
+        rank == 0 ? MPI_IN_PLACE : report,
+        report,
+        batch->len * JOB_REPORT_COUNT,
+        MPI_DOUBLE,
+        MPI_SUM,
+        0,
+        MPI_COMM_WORLD
+    );
+
+    int32_t failed = 0;
+
+    if (rank == 0) {
+        if (format == FORMAT_CSV) {
+            printf("index,path,algo,step,len,velocity,position,seconds,status\n");
+        }
+
+        for (int32_t index = 0; index < batch->len; index += 1) {
+            struct batch_job* job = &batch->jobs[index];
+            const double* row = report + (size_t)index * JOB_REPORT_COUNT;
+
+            job->len = (int32_t)row[JOB_REPORT_LEN];
+            job->velocity = row[JOB_REPORT_VELOCITY];
+            job->position = row[JOB_REPORT_POSITION];
+            job->elapsed.tv_sec = (time_t)row[JOB_REPORT_SECS];
+            job->elapsed.tv_nsec = (long)row[JOB_REPORT_NSECS];
+            job->failed = row[JOB_REPORT_FAILED] != 0.0;
+
+            if (job->failed) {
+                failed = 1;
+            }
+
+            batch_job_print(job, format);
+        }
+
+        fflush(stdout);
+    }
+
+    print_rank_timings("jobs", &timing, rank, ranks);
+
+    free(report);
+    MPI_Win_free(&win);
+
+    MPI_Bcast(&failed, 1, MPI_INT32_T, 0, MPI_COMM_WORLD);
+
+    return failed;
+}
+
+static int32_t run(struct app_args* args, int32_t rank, int32_t ranks) {
+    if (
+        args->convert_path != NULL ||
+        args->trajectory_path != NULL ||
+        args->fleet_path != NULL ||
+        args->serve_path != NULL ||
+        args->index_out_path != NULL ||
+        args->index_path != NULL ||
+        args->stream ||
+        args->sweep_steps_len > 0 ||
+        args->precision != PRECISION_DOUBLE ||
+        args->compress ||
+        args->offload
+    ) {
+        if (rank == 0) {
+            fprintf(stderr, "the distributed runner only supports simulations and batches\n");
+        }
+
+        return 1;
+    }
+
+    if (lut_kernel_select(args->sim.isa) != 0) {
+        return 1;
+    }
+
+    if (args->batch_path != NULL) {
+        struct batch batch;
+        batch_init(&batch);
+
+        int32_t result = 1;
+
+        if (all_ok(batch_load_manifest(&batch, args->batch_path, &args->sim) == 0)) {
+            result = run_farm(&batch, &args->sim, args->format, rank, ranks);
+        }
+
+        batch_free(&batch);
+
+        return result;
+    }
+
+    struct profile accel_profile;
+    profile_init(&accel_profile);
+
+    if (args->file_path != NULL) {
+        if (!all_ok(profile_load(args->file_path, &accel_profile) == 0)) {
+            profile_free(&accel_profile);
+
+            return 1;
+        }
+
+        if (rank == 0) {
+            profile_print_load(&accel_profile);
+        }
+    } else {
+        // fall back to the compiled in table when no file is provided
+        accel_profile.lut.len = TABLE_SIZE;
+        accel_profile.lut.lut = ACCELERATION_DATA;
+    }
+
+    struct lut_info accel_lut = accel_profile.lut;
+    int32_t result = 1;
+
+    if (accel_lut.len < 2) {
+        if (rank == 0) {
+            fprintf(stderr, "acceleration profile must contain at least 2 entries\n");
+        }
+    } else {
+        result = run_distributed(&args->sim, &accel_lut, rank, ranks);
+    }
+
+    profile_free(&accel_profile);
+
+    return result;
+}
+
+int main(int argc, char** argv) {
+    int provided = 0;
+    int rank = 0;
+    int ranks = 1;
+
+    // only the main thread of each rank makes mpi calls, the threads of the
+    // parallel regions never do
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &ranks);
+
+    struct app_args args;
+    int32_t result = 1;
+
+    if (app_args_init(&args, argc, argv) == 0) {
+        result = run(&args, rank, ranks);
+    }
+
+    MPI_Finalize();
+
+    return result;
+}
@@ -0,0 +1,262 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <omp.h>
+
+#include "args.h"
+#include "kernels.h"
+#include "offload.h"
+#include "ts.h"
+
+// the simulation is split into the same three phases as the host runners,
+// each a target region over the resident table
+//
+//   velocity  vel[sec] = i0 * a0 + i1 * slope for every interval
+//   scan      an inclusive scan of vel in blocks of OFFLOAD_BLOCK, a scan of
+//             the block totals and the totals added back to each block
+//   position  the sum of q0 * vel[sec - 1] + j0 * a0 + j1 * slope
+//
+// which gives the same result as the sweep and fused runners up to rounding.
+// without an offload compiler, or without a device at runtime, the target
+// regions run on the host.
+
+void offload_sim_init(struct offload_sim* self) {
+    self->lut = NULL;
+    self->len = 0;
+    self->vel = NULL;
+    self->sums = NULL;
+    self->blocks = 0;
+    self->device = 0;
+    self->host = 1;
+    memset(&self->coeffs, 0, sizeof(self->coeffs));
+
+    timing_init(&self->timing.upload);
+    timing_init(&self->timing.velocity);
+    timing_init(&self->timing.scan);
+    timing_init(&self->timing.position);
+    timing_init(&self->timing.download);
+}
+
+void offload_sim_free(struct offload_sim* self) {
+    omp_target_free(self->lut, self->device);
+    omp_target_free(self->vel, self->device);
+    omp_target_free(self->sums, self->device);
+
+    offload_sim_init(self);
+}
+
+static void offload_timing_update(struct timing* timing, struct timespec* start) {
+    struct timespec end;
+    struct timespec diff;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    timespec_diff(start, &end, &diff);
+    timing_update(timing, &diff);
+
+    *start = end;
+}
+
+// copies the table to the default device and reserves the scan buffers next
+// to it. the table stays on the device until the simulation is freed.
+int32_t offload_sim_upload(struct offload_sim* self, struct sim_args* args, struct lut_info* lut) {
+    offload_sim_free(self);
+
+    int32_t len = lut->len;
+    int32_t blocks = (len + OFFLOAD_BLOCK - 1) / OFFLOAD_BLOCK;
+    size_t bytes = (size_t)len * sizeof(double);
+
+    self->device = omp_get_default_device();
+    self->lut = (double*)omp_target_alloc(bytes, self->device);
+    self->vel = (double*)omp_target_alloc(bytes, self->device);
+    self->sums = (double*)omp_target_alloc((size_t)blocks * sizeof(double), self->device);
+
+    if (self->lut == NULL || self->vel == NULL || self->sums == NULL) {
+        fprintf(stderr, "failed allocating offload buffers on device %d\n", self->device);
+
+        offload_sim_free(self);
+
+        return 1;
+    }
+
+    self->len = len;
+    self->blocks = blocks;
+
+    struct timespec start;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    if (omp_target_memcpy(self->lut, lut->lut, bytes, 0, 0, self->device, omp_get_initial_device()) != 0) {
+        fprintf(stderr, "failed copying the profile to device %d\n", self->device);
+
+        offload_sim_free(self);
+
+        return 1;
+    }
+
+    offload_timing_update(&self->timing.upload, &start);
+
+    const struct lut_kernel* kernel = get_lut_kernel(args->algo);
+    int32_t step = args->step;
+
+    lut_interval_coeffs(kernel, step, &self->coeffs);
+
+    int32_t host = 1;
+
+#pragma omp target map(from: host) device(self->device)
+    host = omp_is_initial_device();
+
+    self->host = host;
+
+    return 0;
+}
+
+// runs a single iteration on the device and reads back the final velocity.
+// every target region without nowait completes before it returns so the host
+// clock measures each kernel.
+void offload_sim_run(struct offload_sim* self, struct sim_result* result) {
+    const double* lut = self->lut;
+    double* vel = self->vel;
+    double* sums = self->sums;
+    int32_t len = self->len;
+    int32_t blocks = self->blocks;
+    int32_t device = self->device;
+    double i0 = self->coeffs.i0;
+    double i1 = self->coeffs.i1;
+    double q0 = self->coeffs.q0;
+    double j0 = self->coeffs.j0;
+    double j1 = self->coeffs.j1;
+    double pos = 0.0;
+    double velocity = 0.0;
+    struct timespec start;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+#pragma omp target teams distribute parallel for is_device_ptr(lut, vel) device(device)
+    for (int32_t sec = 0; sec < len; sec += 1) {
+        if (sec == 0) {
+            vel[sec] = 0.0;
+        } else {
+            double a0 = lut[sec - 1];
+
+            vel[sec] = i0 * a0 + i1 * (lut[sec] - a0);
+        }
+    }
+
+    offload_timing_update(&self->timing.velocity, &start);
+
+#pragma omp target teams distribute parallel for is_device_ptr(vel, sums) device(device)
+    for (int32_t block = 0; block < blocks; block += 1) {
+        int32_t first = block * OFFLOAD_BLOCK;
+        int32_t last = first + OFFLOAD_BLOCK < len ? first + OFFLOAD_BLOCK : len;
+        double sum = 0.0;
+
+        for (int32_t sec = first; sec < last; sec += 1) {
+            sum += vel[sec];
+            vel[sec] = sum;
+        }
+
+        sums[block] = sum;
+    }
+
+    // there is one total per OFFLOAD_BLOCK entries so a single device thread
+    // is enough to turn them into the offset of each block
+#pragma omp target is_device_ptr(sums) device(device)
+    {
+        double sum = 0.0;
+
+        for (int32_t block = 0; block < blocks; block += 1) {
+            double total = sums[block];
+
+            sums[block] = sum;
+            sum += total;
+        }
+    }
+
+#pragma omp target teams distribute parallel for is_device_ptr(vel, sums) device(device)
+    for (int32_t sec = OFFLOAD_BLOCK; sec < len; sec += 1) {
+        vel[sec] += sums[sec / OFFLOAD_BLOCK];
+    }
+
+    offload_timing_update(&self->timing.scan, &start);
+
+#pragma omp target teams distribute parallel for reduction(+: pos) map(tofrom: pos) is_device_ptr(lut, vel) device(device)
+    for (int32_t sec = 1; sec < len; sec += 1) {
+        double a0 = lut[sec - 1];
+
+        pos += q0 * vel[sec - 1] + j0 * a0 + j1 * (lut[sec] - a0);
+    }
+
+    offload_timing_update(&self->timing.position, &start);
+
+    omp_target_memcpy(
+        &velocity,
+        vel,
+        sizeof(double),
+        0,
+        (size_t)(len - 1) * sizeof(double),
+        omp_get_initial_device(),
+        device
+    );
+
+    offload_timing_update(&self->timing.download, &start);
+
+    result->velocity = velocity;
+    result->position = pos;
+}
+
+static void offload_timing_print_phase(const char* name, const struct timing* timing) {
+    struct timespec avg = {0, 0};
+    struct timespec total = timing->total;
+
+    if (timing->count > 0 && timespec_div(&total, timing->count, &avg) != 0) {
+        printf("bad nanos calculated\n");
+
+        return;
+    }
+
+    printf(
+        "%s: avg: %ld.%.9ld tot: %ld.%.9ld\n",
+        name,
+        avg.tv_sec,
+        avg.tv_nsec,
+        timing->total.tv_sec,
+        timing->total.tv_nsec
+    );
+}
+
+// prints each phase along with the transfers against the kernels. the upload
+// only happens once so it is paid off when it is small next to every
+// iteration the table stays resident for.
+void offload_timing_print(const struct offload_timing* self) {
+    offload_timing_print_phase("upload", &self->upload);
+    offload_timing_print_phase("velocity", &self->velocity);
+    offload_timing_print_phase("scan", &self->scan);
+    offload_timing_print_phase("position", &self->position);
+    offload_timing_print_phase("download", &self->download);
+
+    struct timespec transfer;
+    struct timespec compute;
+    struct timespec upload = self->upload.total;
+    struct timespec download = self->download.total;
+    struct timespec velocity = self->velocity.total;
+    struct timespec scan = self->scan.total;
+    struct timespec position = self->position.total;
+
+    timespec_add(&upload, &download, &transfer);
+    timespec_add(&velocity, &scan, &compute);
+    timespec_add(&compute, &position, &compute);
+
+    double transfer_secs = (double)transfer.tv_sec + (double)transfer.tv_nsec / 1e9;
+    double compute_secs = (double)compute.tv_sec + (double)compute.tv_nsec / 1e9;
+
+    printf(
+        "transfer: %ld.%.9ld compute: %ld.%.9ld (%.1lf%% transfer)\n",
+        transfer.tv_sec,
+        transfer.tv_nsec,
+        compute.tv_sec,
+        compute.tv_nsec,
+        transfer_secs + compute_secs > 0.0 ? 100.0 * transfer_secs / (transfer_secs + compute_secs) : 0.0
+    );
+}
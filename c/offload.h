@@ -0,0 +1,56 @@
+#ifndef OFFLOAD_H
+#define OFFLOAD_H
+
+#include <stdint.h>
+#include <time.h>
+
+#include "context.h"
+#include "kernels.h"
+#include "summation.h"
+#include "ts.h"
+
+// the entries of the table each device thread scans on its own before the
+// per block totals are scanned and added back
+#define OFFLOAD_BLOCK 4096
+
+// the time spent on each side of the device. upload and download are the
+// transfers, the rest are the kernels of each iteration.
+struct offload_timing {
+    struct timing upload;
+    struct timing velocity;
+    struct timing scan;
+    struct timing position;
+    struct timing download;
+};
+
+// a simulation offloaded to the default device with the table kept resident
+// on it between iterations. the algo reduces to the coefficients of a single
+// interval the same as a sweep so the device kernels do not need the kernel
+// tables of the host.
+struct offload_sim {
+    // the table on the device and the number of entries in it
+    double* lut;
+    int32_t len;
+    // the velocity gained over each interval and then, after the scan, the
+    // velocity at the end of it. only lives on the device.
+    double* vel;
+    double* sums;
+    int32_t blocks;
+    int32_t device;
+    // non zero when the target regions execute on the host
+    int32_t host;
+
+    struct lut_interval_coeffs coeffs;
+
+    struct offload_timing timing;
+};
+
+void offload_sim_init(struct offload_sim* self);
+void offload_sim_free(struct offload_sim* self);
+
+int32_t offload_sim_upload(struct offload_sim* self, struct sim_args* args, struct lut_info* lut);
+void offload_sim_run(struct offload_sim* self, struct sim_result* result);
+
+void offload_timing_print(const struct offload_timing* self);
+
+#endif
@@ -0,0 +1,124 @@
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <omp.h>
+
+#include "args.h"
+#include "parallel.h"
+
+// splits [begin, end) into contiguous ranges for each thread of the current
+// parallel region in the same way as a static schedule would
+void parallel_thread_range(int32_t begin, int32_t end, int32_t* first, int32_t* last) {
+    int32_t threads = omp_get_num_threads();
+    int32_t thread = omp_get_thread_num();
+    int32_t total = end - begin;
+    int32_t chunk = total / threads;
+    int32_t extra = total % threads;
+
+    *first = begin + thread * chunk + (thread < extra ? thread : extra);
+    *last = *first + chunk + (thread < extra ? 1 : 0);
+}
+
+// the exclusive prefix of the per thread partial sums for the given thread.
+// the number of threads is small so each thread adds up the partials before
+// it instead of waiting on a single thread to scan them.
+double parallel_thread_offset(const double* partials, int32_t thread) {
+    double offset = 0.0;
+
+    for (int32_t prev = 0; prev < thread; prev += 1) {
+        offset += partials[prev * THREAD_PAD];
+    }
+
+    return offset;
+}
+
+// pins each thread of a parallel region of the given size to its own cpu out
+// of the cpus the process is allowed to run on. the OpenMP runtime keeps the
+// same threads for later regions of the same size so the pinning carries
+// over to the runners.
+int32_t parallel_bind_threads(int32_t threads, int32_t bind) {
+    cpu_set_t allowed;
+
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        fprintf(stderr, "failed to retrieve cpu affinity. %s\n", strerror(errno));
+
+        return 1;
+    }
+
+    int32_t cpus[CPU_SETSIZE];
+    int32_t count = 0;
+
+    for (int32_t cpu = 0; cpu < CPU_SETSIZE; cpu += 1) {
+        if (CPU_ISSET(cpu, &allowed)) {
+            cpus[count] = cpu;
+            count += 1;
+        }
+    }
+
+    int32_t failed = 0;
+
+#pragma omp parallel num_threads(threads) reduction(|:failed)
+    {
+        int32_t thread = omp_get_thread_num();
+        int32_t total = omp_get_num_threads();
+        // close fills the cpus in order while spread leaves an even gap
+        // between each thread
+        int32_t slot = bind == BIND_SPREAD && total < count
+            ? (int32_t)((int64_t)thread * count / total)
+            : thread % count;
+        cpu_set_t set;
+
+        CPU_ZERO(&set);
+        CPU_SET(cpus[slot], &set);
+
+        if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+            failed = 1;
+        }
+    }
+
+    if (failed) {
+        fprintf(stderr, "failed to pin threads to cpus. %s\n", strerror(errno));
+
+        return 1;
+    }
+
+    return 0;
+}
+
+// sums the values as a balanced tree, combining neighbours at each level. the
+// shape of the tree only depends on the number of values so the result does
+// too. the values are overwritten with the partial sums.
+double parallel_pairwise_sum(double* values, int32_t len) {
+    if (len == 0) {
+        return 0.0;
+    }
+
+    for (int32_t width = 1; width < len; width *= 2) {
+        for (int32_t index = 0; index + width < len; index += 2 * width) {
+            values[index] += values[index + width];
+        }
+    }
+
+    return values[0];
+}
+
+// sums the values in order while carrying the rounding error of each addition
+// into the next one
+double parallel_kahan_sum(const double* values, int32_t len) {
+    double sum = 0.0;
+    double compensation = 0.0;
+
+    for (int32_t index = 0; index < len; index += 1) {
+        double y = values[index] - compensation;
+        double t = sum + y;
+
+        compensation = (t - sum) - y;
+        sum = t;
+    }
+
+    return sum;
+}
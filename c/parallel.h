@@ -0,0 +1,18 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <stdint.h>
+
+// per thread values are spread out by this many doubles so that each thread
+// writes to its own cache line
+#define THREAD_PAD 8
+
+void parallel_thread_range(int32_t begin, int32_t end, int32_t* first, int32_t* last);
+double parallel_thread_offset(const double* partials, int32_t thread);
+
+int32_t parallel_bind_threads(int32_t threads, int32_t bind);
+
+double parallel_pairwise_sum(double* values, int32_t len);
+double parallel_kahan_sum(const double* values, int32_t len);
+
+#endif
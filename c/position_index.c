@@ -0,0 +1,521 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "args.h"
+#include "context.h"
+#include "position_index.h"
+#include "trajectory.h"
+
+void position_index_init(struct position_index* self) {
+    self->len = 0;
+    self->run_count = 0;
+    self->algo = 0;
+    self->step = 0;
+    self->coeffs = NULL;
+    self->runs = NULL;
+    self->map = NULL;
+    self->map_len = 0;
+    self->mapped = 0;
+}
+
+void position_index_free(struct position_index* self) {
+    if (self->mapped) {
+        munmap(self->map, self->map_len);
+    } else {
+        free(self->map);
+    }
+
+    position_index_init(self);
+}
+
+static size_t position_index_size(uint32_t len, uint32_t runs) {
+    return sizeof(struct position_index_header) +
+        (size_t)(len - 1) * 4 * sizeof(double) +
+        (size_t)runs * sizeof(struct position_index_run);
+}
+
+// points the index at the sections of a validated header and the data after it
+static void position_index_attach(struct position_index* self, void* map, size_t map_len, int32_t mapped) {
+    const struct position_index_header* header = (const struct position_index_header*)map;
+    const char* base = (const char*)map + header->header_size;
+
+    self->len = (int32_t)header->len;
+    self->run_count = (int32_t)header->runs;
+    self->algo = header->algo;
+    self->step = header->step;
+    self->coeffs = (const double*)base;
+    self->runs = (const struct position_index_run*)(base + (size_t)(header->len - 1) * 4 * sizeof(double));
+    self->map = map;
+    self->map_len = map_len;
+    self->mapped = mapped;
+}
+
+static inline double position_index_cubic(const double* c, double t) {
+    return c[0] + t * (c[1] + t * (c[2] + t * c[3]));
+}
+
+// the roots of the derivative of the cubic inside of (0, 1) where its sign
+// changes, in order. returns the number of roots
+static int32_t position_index_turns(const double* c, double* roots) {
+    double a = 3.0 * c[3];
+    double b = 2.0 * c[2];
+    double k = c[1];
+    int32_t count = 0;
+
+    if (a == 0.0) {
+        if (b != 0.0) {
+            roots[count] = -k / b;
+            count += 1;
+        }
+    } else {
+        double disc = b * b - 4.0 * a * k;
+
+        // a double root touches zero without changing the direction
+        if (disc > 0.0) {
+            double q = -0.5 * (b + copysign(sqrt(disc), b));
+
+            roots[count] = q / a;
+            count += 1;
+
+            if (q != 0.0) {
+                roots[count] = k / q;
+                count += 1;
+            }
+        }
+    }
+
+    if (count == 2 && roots[1] < roots[0]) {
+        double swap = roots[0];
+        roots[0] = roots[1];
+        roots[1] = swap;
+    }
+
+    int32_t inside = 0;
+
+    for (int32_t index = 0; index < count; index += 1) {
+        if (roots[index] > 0.0 && roots[index] < 1.0) {
+            roots[inside] = roots[index];
+            inside += 1;
+        }
+    }
+
+    return inside;
+}
+
+// splits the cubics into the maximal runs of time where the position only
+// moves in one direction. every interval is cut at the turning points of its
+// cubic and neighbouring runs share the time where the direction changes.
+// only counts the runs when out is NULL.
+static int32_t position_index_runs(const double* coeffs, int32_t len, struct position_index_run* out) {
+    int32_t count = 0;
+    double start = 0.0;
+    int32_t direction = 0;
+
+    for (int32_t sec = 0; sec + 1 < len; sec += 1) {
+        const double* c = coeffs + (size_t)sec * 4;
+        double cuts[3];
+        int32_t cut_count = position_index_turns(c, cuts);
+
+        cuts[cut_count] = 1.0;
+        cut_count += 1;
+
+        double from = 0.0;
+        double from_pos = c[0];
+
+        for (int32_t index = 0; index < cut_count; index += 1) {
+            double to_pos = position_index_cubic(c, cuts[index]);
+            double diff = to_pos - from_pos;
+            int32_t moved = diff > 0.0 ? 1 : (diff < 0.0 ? -1 : 0);
+
+            if (moved != 0 && direction != 0 && moved != direction) {
+                double turn = (double)sec + from;
+
+                if (out != NULL) {
+                    out[count].start = start;
+                    out[count].end = turn;
+                    out[count].direction = direction;
+                    out[count].reserved = 0;
+                }
+
+                count += 1;
+                start = turn;
+                direction = moved;
+            } else if (direction == 0) {
+                direction = moved;
+            }
+
+            from = cuts[index];
+            from_pos = to_pos;
+        }
+    }
+
+    if (out != NULL) {
+        out[count].start = start;
+        out[count].end = (double)(len - 1);
+        out[count].direction = direction == 0 ? 1 : direction;
+        out[count].reserved = 0;
+    }
+
+    return count + 1;
+}
+
+// simulates the profile once and builds the index of it in memory
+int32_t position_index_build(struct position_index* self, struct sim_args* args, struct lut_info* lut) {
+    position_index_free(self);
+
+    if (lut->len < 2) {
+        fprintf(stderr, "acceleration profile must contain at least 2 entries\n");
+
+        return 1;
+    }
+
+    struct sim_context context;
+
+    if (sim_context_init(&context, args, 0) != 0) {
+        sim_context_free(&context);
+
+        return 1;
+    }
+
+    struct trajectory_sample* samples = (struct trajectory_sample*)malloc(
+        (size_t)lut->len * sizeof(struct trajectory_sample)
+    );
+
+    if (samples == NULL) {
+        fprintf(stderr, "failed allocating index samples. %s\n", strerror(errno));
+
+        sim_context_free(&context);
+
+        return 1;
+    }
+
+    struct sim_result result;
+    int32_t rtn = sim_context_samples(&context, lut, samples, &result);
+
+    sim_context_free(&context);
+
+    if (rtn != 0) {
+        free(samples);
+
+        return 1;
+    }
+
+    uint32_t len = (uint32_t)lut->len;
+    size_t coeff_bytes = sizeof(struct position_index_header) + (size_t)(len - 1) * 4 * sizeof(double);
+    char* map = (char*)malloc(coeff_bytes);
+
+    if (map == NULL) {
+        fprintf(stderr, "failed allocating position index. %s\n", strerror(errno));
+
+        free(samples);
+
+        return 1;
+    }
+
+    double* coeffs = (double*)(map + sizeof(struct position_index_header));
+
+    for (uint32_t sec = 0; sec + 1 < len; sec += 1) {
+        double p0 = samples[sec].pos;
+        double p1 = samples[sec + 1].pos;
+        double v0 = samples[sec].vel;
+        double v1 = samples[sec + 1].vel;
+
+        coeffs[sec * 4] = p0;
+        coeffs[sec * 4 + 1] = v0;
+        coeffs[sec * 4 + 2] = 3.0 * (p1 - p0) - 2.0 * v0 - v1;
+        coeffs[sec * 4 + 3] = 2.0 * (p0 - p1) + v0 + v1;
+    }
+
+    free(samples);
+
+    // the runs are only known once the cubics are so they are added after
+    uint32_t runs = (uint32_t)position_index_runs(coeffs, lut->len, NULL);
+    size_t bytes = position_index_size(len, runs);
+    char* grown = (char*)realloc(map, bytes);
+
+    if (grown == NULL) {
+        fprintf(stderr, "failed allocating position index runs. %s\n", strerror(errno));
+
+        free(map);
+
+        return 1;
+    }
+
+    map = grown;
+    coeffs = (double*)(map + sizeof(struct position_index_header));
+
+    position_index_runs(coeffs, lut->len, (struct position_index_run*)(map + coeff_bytes));
+
+    struct position_index_header* header = (struct position_index_header*)map;
+
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, POSITION_INDEX_MAGIC, POSITION_INDEX_MAGIC_LEN);
+    header->version = POSITION_INDEX_VERSION;
+    header->header_size = sizeof(*header);
+    header->len = len;
+    header->runs = runs;
+    header->algo = args->algo;
+    header->step = args->step;
+    header->endian = POSITION_INDEX_ENDIAN;
+
+    position_index_attach(self, map, bytes, 0);
+
+    return 0;
+}
+
+int32_t position_index_write(const struct position_index* self, const char* file_path) {
+    FILE* file = fopen(file_path, "wb");
+
+    if (file == NULL) {
+        fprintf(stderr, "failed to create position index \"%s\". %s\n", file_path, strerror(errno));
+
+        return 1;
+    }
+
+    int32_t result = fwrite(self->map, 1, self->map_len, file) != self->map_len;
+
+    if (fclose(file) != 0) {
+        result = 1;
+    }
+
+    if (result != 0) {
+        fprintf(stderr, "failed writing position index \"%s\". %s\n", file_path, strerror(errno));
+    }
+
+    return result;
+}
+
+// the runs pick the range of time every search looks in so every one of
+// them is checked before the index is used. the runs must cover [0, len - 1]
+// in order with each one starting where the one before it ended
+static int32_t position_index_check_runs(const struct position_index* self) {
+    double expected = 0.0;
+
+    for (int32_t index = 0; index < self->run_count; index += 1) {
+        const struct position_index_run* run = &self->runs[index];
+
+        // written so a nan fails every comparison
+        if (
+            !(run->start == expected) ||
+            !(run->end >= run->start) ||
+            !(run->end <= (double)(self->len - 1)) ||
+            (run->direction != 1 && run->direction != -1)
+        ) {
+            fprintf(
+                stderr,
+                "invalid position index run %d. start: %lf end: %lf direction: %d\n",
+                index,
+                run->start,
+                run->end,
+                run->direction
+            );
+
+            return 1;
+        }
+
+        expected = run->end;
+    }
+
+    if (expected != (double)(self->len - 1)) {
+        fprintf(stderr, "position index runs end at %lf instead of %d\n", expected, self->len - 1);
+
+        return 1;
+    }
+
+    return 0;
+}
+
+// maps an index written by position_index_write. the queries only touch the
+// pages of the intervals they land in.
+int32_t position_index_load(struct position_index* self, const char* file_path) {
+    position_index_free(self);
+
+    int fd = open(file_path, O_RDONLY);
+
+    if (fd < 0) {
+        fprintf(stderr, "failed to open position index \"%s\". %s\n", file_path, strerror(errno));
+
+        return 1;
+    }
+
+    struct stat info;
+
+    if (fstat(fd, &info) != 0) {
+        fprintf(stderr, "failed to stat position index. %s\n", strerror(errno));
+
+        close(fd);
+
+        return 1;
+    }
+
+    size_t file_len = (size_t)info.st_size;
+
+    if (file_len < sizeof(struct position_index_header)) {
+        fprintf(stderr, "position index is too small to contain a header\n");
+
+        close(fd);
+
+        return 1;
+    }
+
+    void* map = mmap(NULL, file_len, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    // the mapping keeps its own reference to the file
+    close(fd);
+
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "failed to map position index. %s\n", strerror(errno));
+
+        return 1;
+    }
+
+    const struct position_index_header* header = (const struct position_index_header*)map;
+
+    if (
+        memcmp(header->magic, POSITION_INDEX_MAGIC, POSITION_INDEX_MAGIC_LEN) != 0 ||
+        header->version != POSITION_INDEX_VERSION ||
+        header->endian != POSITION_INDEX_ENDIAN
+    ) {
+        fprintf(stderr, "unknown position index format. version: %u\n", header->version);
+
+        munmap(map, file_len);
+
+        return 1;
+    }
+
+    if (
+        header->header_size != sizeof(*header) ||
+        header->len < 2 ||
+        header->len > INT32_MAX ||
+        header->runs < 1 ||
+        position_index_size(header->len, header->runs) != file_len
+    ) {
+        fprintf(
+            stderr,
+            "position index does not match its file size. len: %u runs: %u size: %lu\n",
+            header->len,
+            header->runs,
+            (unsigned long)file_len
+        );
+
+        munmap(map, file_len);
+
+        return 1;
+    }
+
+    madvise(map, file_len, MADV_RANDOM);
+
+    position_index_attach(self, map, file_len, 1);
+
+    if (position_index_check_runs(self) != 0) {
+        position_index_free(self);
+
+        return 1;
+    }
+
+    return 0;
+}
+
+size_t position_index_bytes(const struct position_index* self) {
+    return self->map_len;
+}
+
+// the velocity and position at a time in [0, len - 1] from the cubic of the
+// interval holding it
+void position_index_at(const struct position_index* self, double time, double* vel, double* pos) {
+    int32_t sec = (int32_t)time;
+
+    if (sec > self->len - 2) {
+        sec = self->len - 2;
+    }
+
+    const double* c = self->coeffs + (size_t)sec * 4;
+    double t = time - (double)sec;
+
+    *pos = position_index_cubic(c, t);
+    *vel = c[1] + t * (2.0 * c[2] + t * 3.0 * c[3]);
+}
+
+// finds the first time at or after the given one where the train is at the
+// position. the run holding the start is found by binary search and every
+// run from there on is checked in order. the position is monotone over a run
+// so the time inside of it is found by bisection. returns 1 when the
+// position is never reached.
+int32_t position_index_time(const struct position_index* self, double position, double after, double* time) {
+    if (!(after >= 0.0)) {
+        after = 0.0;
+    }
+
+    if (after > (double)(self->len - 1)) {
+        return 1;
+    }
+
+    int32_t lower = 0;
+    int32_t upper = self->run_count - 1;
+
+    while (lower < upper) {
+        int32_t mid = (lower + upper + 1) / 2;
+
+        if (self->runs[mid].start <= after) {
+            lower = mid;
+        } else {
+            upper = mid - 1;
+        }
+    }
+
+    for (int32_t index = lower; index < self->run_count; index += 1) {
+        const struct position_index_run* run = &self->runs[index];
+        double direction = (double)run->direction;
+        double a = index == lower && after > run->start ? after : run->start;
+        double b = run->end;
+        double vel;
+        double from;
+        double to;
+
+        position_index_at(self, a, &vel, &from);
+        position_index_at(self, b, &vel, &to);
+
+        if ((position - from) * direction < 0.0 || (to - position) * direction < 0.0) {
+            continue;
+        }
+
+        if (from == position) {
+            *time = a;
+
+            return 0;
+        }
+
+        // a range of 1e9 entries halves down to a single ulp well before this
+        for (int32_t iter = 0; iter < 128; iter += 1) {
+            double mid = a + (b - a) / 2.0;
+            double pos;
+
+            if (mid <= a || mid >= b) {
+                break;
+            }
+
+            position_index_at(self, mid, &vel, &pos);
+
+            if ((pos - position) * direction >= 0.0) {
+                b = mid;
+            } else {
+                a = mid;
+            }
+        }
+
+        *time = b;
+
+        return 0;
+    }
+
+    return 1;
+}
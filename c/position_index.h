@@ -0,0 +1,77 @@
+#ifndef POSITION_INDEX_H
+#define POSITION_INDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "args.h"
+#include "summation.h"
+
+// 8 byte identifier at the start of every position index file
+#define POSITION_INDEX_MAGIC "TSIMIDX\0"
+#define POSITION_INDEX_MAGIC_LEN 8
+#define POSITION_INDEX_VERSION 2
+// written as is so an index from a host of the other byte order is rejected
+#define POSITION_INDEX_ENDIAN 0x01020304u
+
+// sidecar file holding the position over a simulated profile so queries do
+// not need to simulate it again. the file is stored in host byte order and
+// is used in place once mapped.
+//
+// | magic (8) | version (4) | header_size (4) | len (4) | runs (4) |
+// | algo (4) | step (4) | endian (4) | reserved (4) |
+// | (len - 1) * 4 double coefficients | runs * position_index_run |
+//
+// interval k of the profile has the coefficients c0 through c3 of the cubic
+// p(t) = c0 + c1 t + c2 t^2 + c3 t^3 for t in [0, 1], the hermite through the
+// position and velocity at either end of the interval.
+struct position_index_header {
+    char magic[POSITION_INDEX_MAGIC_LEN];
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t len;
+    uint32_t runs;
+    int32_t algo;
+    int32_t step;
+    uint32_t endian;
+    uint32_t reserved;
+};
+
+// a maximal range of time [start, end] where the position only moves in one
+// direction, 1 for forward and -1 for backward. the boundaries fall on the
+// turning points of the cubics so a run can start or end inside an interval
+struct position_index_run {
+    double start;
+    double end;
+    int32_t direction;
+    int32_t reserved;
+};
+
+struct position_index {
+    int32_t len;
+    int32_t run_count;
+    int32_t algo;
+    int32_t step;
+
+    const double* coeffs;
+    const struct position_index_run* runs;
+
+    // the header and everything after it, either mapped from a file or
+    // allocated by an index that was built in memory
+    void* map;
+    size_t map_len;
+    int32_t mapped;
+};
+
+void position_index_init(struct position_index* self);
+void position_index_free(struct position_index* self);
+
+int32_t position_index_build(struct position_index* self, struct sim_args* args, struct lut_info* lut);
+int32_t position_index_write(const struct position_index* self, const char* file_path);
+int32_t position_index_load(struct position_index* self, const char* file_path);
+size_t position_index_bytes(const struct position_index* self);
+
+void position_index_at(const struct position_index* self, double time, double* vel, double* pos);
+int32_t position_index_time(const struct position_index* self, double position, double after, double* time);
+
+#endif
@@ -0,0 +1,62 @@
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "args.h"
+#include "kernels.h"
+#include "precision.h"
+#include "simd.h"
+
+DEFINE_SUMMATIONS_T(segment_f, const struct lut_segment_f*, segment_f_interpolate, float)
+DEFINE_LUT_KERNELS_F(SCALAR_LUT_KERNELS_F, segment_f, segment, )
+
+// copies the table into single precision
+int32_t lut_info_f_init(struct lut_info_f* self, const struct lut_info* lut) {
+    self->len = 0;
+    self->lut = (float*)malloc((size_t)lut->len * sizeof(float));
+
+    if (self->lut == NULL) {
+        fprintf(stderr, "failed allocating single precision lookup table. %s\n", strerror(errno));
+
+        return 1;
+    }
+
+    for (int32_t index = 0; index < lut->len; index += 1) {
+        self->lut[index] = (float)lut->lut[index];
+    }
+
+    self->len = lut->len;
+
+    return 0;
+}
+
+void lut_info_f_free(struct lut_info_f* self) {
+    free(self->lut);
+
+    self->lut = NULL;
+    self->len = 0;
+}
+
+// the single precision kernels for the instruction set selected for the
+// double kernels. only the fixed step summations have single precision
+// kernels so NULL is returned for the others
+const struct lut_kernel_f* get_lut_kernel_f(int32_t algo) {
+    if (algo < 0 || algo >= LUT_KERNEL_COUNT) {
+        return NULL;
+    }
+
+    const struct lut_kernel_f* kernels = NULL;
+    int32_t isa = lut_kernel_isa();
+
+    if (isa != ISA_SCALAR) {
+        kernels = get_simd_kernels_f(isa);
+    }
+
+    if (kernels == NULL) {
+        kernels = SCALAR_LUT_KERNELS_F;
+    }
+
+    return &kernels[algo];
+}
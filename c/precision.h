@@ -0,0 +1,145 @@
+#ifndef PRECISION_H
+#define PRECISION_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "context.h"
+#include "kernels.h"
+#include "summation.h"
+
+// a lookup table stored in single precision
+struct lut_info_f {
+    int32_t len;
+    float* lut;
+};
+
+// fused pass over a single precision table. the state is always returned in
+// double precision so it can be compared against the double kernels.
+typedef void (*lut_fused_f)(const struct lut_info_f* lut, int32_t first, int32_t last, int32_t step, struct fused_state* state);
+
+// the single precision kernels for one summation algorithm. float evaluates
+// and accumulates everything in single precision with kahan compensation for
+// the running velocity and position. mixed evaluates each interval in single
+// precision but accumulates in double.
+struct lut_kernel_f {
+    const char* name;
+    lut_fused_f fused_float;
+    lut_fused_f fused_mixed;
+};
+
+int32_t lut_info_f_init(struct lut_info_f* self, const struct lut_info* lut);
+void lut_info_f_free(struct lut_info_f* self);
+
+const struct lut_kernel_f* get_lut_kernel_f(int32_t algo);
+
+// a single linear piece of a single precision table, see struct lut_segment
+struct lut_segment_f {
+    float y0;
+    float slope;
+};
+
+static inline float segment_f_interpolate(const struct lut_segment_f* seg, float t) {
+    return seg->y0 + t * seg->slope;
+}
+
+// adds value to sum while carrying the rounding error of every addition in
+// compensation so it is added back in on the next one. this relies on the
+// compiler not reassociating floating point math which gcc only does with
+// -ffast-math.
+static inline void kahan_add_f(float* sum, float* compensation, float value) {
+    float y = value - *compensation;
+    float t = *sum + y;
+
+    *compensation = (t - *sum) - y;
+    *sum = t;
+}
+
+// generates the float and mixed fused passes from a single precision segment
+// summation and the double precision segment summation of the same rule.
+// both follow the double fused pass in kernels.h.
+#define DEFINE_LUT_KERNEL_F_ATTR(sum_f, sum_d, attr)                         \
+attr static void sum_f##_fused_float(                                        \
+    const struct lut_info_f* lut,                                            \
+    int32_t first,                                                           \
+    int32_t last,                                                            \
+    int32_t step,                                                            \
+    struct fused_state* state                                                \
+) {                                                                          \
+    float vel = (float)state->vel;                                           \
+    float pos = (float)state->pos;                                           \
+    float vel_c = 0.0f;                                                      \
+    float pos_c = 0.0f;                                                      \
+                                                                             \
+    for (int32_t sec = first; sec < last; sec += 1) {                        \
+        struct lut_segment_f seg;                                            \
+        seg.y0 = lut->lut[sec - 1];                                          \
+        seg.slope = lut->lut[sec] - seg.y0;                                  \
+                                                                             \
+        float dv = sum_f(&seg, 0.0f, 1.0f, step);                            \
+                                                                             \
+        struct lut_segment_f vel_seg;                                        \
+        vel_seg.y0 = vel;                                                    \
+        vel_seg.slope = dv;                                                  \
+                                                                             \
+        kahan_add_f(&pos, &pos_c, sum_f(&vel_seg, 0.0f, 1.0f, step));        \
+        kahan_add_f(&vel, &vel_c, dv);                                       \
+    }                                                                        \
+                                                                             \
+    state->vel = (double)vel - (double)vel_c;                                \
+    state->pos = (double)pos - (double)pos_c;                                \
+}                                                                            \
+                                                                             \
+attr static void sum_f##_fused_mixed(                                        \
+    const struct lut_info_f* lut,                                            \
+    int32_t first,                                                           \
+    int32_t last,                                                            \
+    int32_t step,                                                            \
+    struct fused_state* state                                                \
+) {                                                                          \
+    double vel = state->vel;                                                 \
+    double pos = state->pos;                                                 \
+                                                                             \
+    for (int32_t sec = first; sec < last; sec += 1) {                        \
+        struct lut_segment_f seg;                                            \
+        seg.y0 = lut->lut[sec - 1];                                          \
+        seg.slope = lut->lut[sec] - seg.y0;                                  \
+                                                                             \
+        double dv = (double)sum_f(&seg, 0.0f, 1.0f, step);                   \
+                                                                             \
+        /* the velocity is too large to be kept in single precision so */    \
+        /* its segment is summed in double */                                \
+        struct lut_segment vel_seg;                                          \
+        vel_seg.y0 = vel;                                                    \
+        vel_seg.slope = dv;                                                  \
+                                                                             \
+        pos += sum_d(&vel_seg, 0.0, 1.0, step);                              \
+        vel += dv;                                                           \
+    }                                                                        \
+                                                                             \
+    state->vel = vel;                                                        \
+    state->pos = pos;                                                        \
+}
+
+#define LUT_KERNEL_F_ENTRY(label, sum_f) \
+    { label, sum_f##_fused_float, sum_f##_fused_mixed }
+
+// generates the single precision kernels for all of the <prefix_f>_<algo>
+// summations paired with the <prefix_d>_<algo> double summations and a table
+// of them indexed by enum ALGO
+#define DEFINE_LUT_KERNELS_F(table, prefix_f, prefix_d, attr)                \
+    DEFINE_LUT_KERNEL_F_ATTR(prefix_f##_left_riemann, prefix_d##_left_riemann, attr) \
+    DEFINE_LUT_KERNEL_F_ATTR(prefix_f##_mid_riemann, prefix_d##_mid_riemann, attr) \
+    DEFINE_LUT_KERNEL_F_ATTR(prefix_f##_right_riemann, prefix_d##_right_riemann, attr) \
+    DEFINE_LUT_KERNEL_F_ATTR(prefix_f##_trapezoidal, prefix_d##_trapezoidal, attr) \
+    DEFINE_LUT_KERNEL_F_ATTR(prefix_f##_simpsons, prefix_d##_simpsons, attr) \
+                                                                             \
+    static const struct lut_kernel_f table[LUT_KERNEL_COUNT] = {             \
+        LUT_KERNEL_F_ENTRY("left-riemann", prefix_f##_left_riemann),         \
+        LUT_KERNEL_F_ENTRY("mid-riemann", prefix_f##_mid_riemann),           \
+        LUT_KERNEL_F_ENTRY("right-riemann", prefix_f##_right_riemann),       \
+        LUT_KERNEL_F_ENTRY("trapezoidal", prefix_f##_trapezoidal),           \
+        LUT_KERNEL_F_ENTRY("simpsons", prefix_f##_simpsons),                 \
+    };
+
+#endif
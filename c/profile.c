@@ -0,0 +1,371 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "csv.h"
+#include "profile.h"
+#include "ts.h"
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define PROFILE_SWAP_BYTES 1
+#else
+#define PROFILE_SWAP_BYTES 0
+#endif
+
+static uint32_t swap_u32(uint32_t value) {
+#if PROFILE_SWAP_BYTES
+    return __builtin_bswap32(value);
+#else
+    return value;
+#endif
+}
+
+static uint64_t swap_u64(uint64_t value) {
+#if PROFILE_SWAP_BYTES
+    return __builtin_bswap64(value);
+#else
+    return value;
+#endif
+}
+
+static double swap_f64(double value) {
+#if PROFILE_SWAP_BYTES
+    uint64_t bits;
+
+    memcpy(&bits, &value, sizeof(bits));
+    bits = __builtin_bswap64(bits);
+    memcpy(&value, &bits, sizeof(bits));
+#endif
+    return value;
+}
+
+void profile_init(struct profile* self) {
+    self->lut.len = 0;
+    self->lut.lut = NULL;
+    self->sample_rate = 1.0;
+    self->map = NULL;
+    self->map_len = 0;
+    self->owned = NULL;
+    self->load_bytes = 0;
+    self->load_time.tv_sec = 0;
+    self->load_time.tv_nsec = 0;
+}
+
+void profile_free(struct profile* self) {
+    if (self->map != NULL) {
+        munmap(self->map, self->map_len);
+    }
+
+    free(self->owned);
+
+    profile_init(self);
+}
+
+// checks the first few bytes of the file for the binary magic and hands the
+// file off to the appropriate loader. anything that is not a binary profile
+// is treated as a csv file with a single column of acceleration values.
+int32_t profile_load(const char* file_path, struct profile* profile) {
+    char magic[PROFILE_MAGIC_LEN];
+    FILE* file = fopen(file_path, "rb");
+
+    if (file == NULL) {
+        fprintf(stderr, "failed to open data file \"%s\". %s\n", file_path, strerror(errno));
+
+        return 1;
+    }
+
+    size_t read = fread(magic, 1, PROFILE_MAGIC_LEN, file);
+
+    fclose(file);
+
+    struct timespec start;
+    struct timespec end;
+    int32_t result = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    if (read == PROFILE_MAGIC_LEN && memcmp(magic, PROFILE_MAGIC, PROFILE_MAGIC_LEN) == 0) {
+        result = profile_load_binary(file_path, profile);
+    } else {
+        result = profile_load_csv(file_path, profile);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    if (result == 0) {
+        timespec_diff(&start, &end, &profile->load_time);
+    }
+
+    return result;
+}
+
+// prints the amount of data loaded and the rate it was loaded at
+void profile_print_load(struct profile* self) {
+    double seconds = (double)self->load_time.tv_sec + (double)self->load_time.tv_nsec / 1e9;
+    double mb = (double)self->load_bytes / (1024.0 * 1024.0);
+
+    if (seconds > 0.0) {
+        printf(
+            "loaded: %d entries %.3lf MB in %ld.%.9ld (%.3lf MB/s)\n",
+            self->lut.len,
+            mb,
+            self->load_time.tv_sec,
+            self->load_time.tv_nsec,
+            mb / seconds
+        );
+    } else {
+        printf("loaded: %d entries %.3lf MB\n", self->lut.len, mb);
+    }
+}
+
+int32_t profile_load_binary(const char* file_path, struct profile* profile) {
+    profile_init(profile);
+
+    int fd = open(file_path, O_RDONLY);
+
+    if (fd < 0) {
+        fprintf(stderr, "failed to open binary profile \"%s\". %s\n", file_path, strerror(errno));
+
+        return 1;
+    }
+
+    struct stat info;
+
+    if (fstat(fd, &info) != 0) {
+        fprintf(stderr, "failed to stat binary profile. %s\n", strerror(errno));
+
+        close(fd);
+
+        return 1;
+    }
+
+    size_t file_len = (size_t)info.st_size;
+
+    if (file_len < sizeof(struct profile_header)) {
+        fprintf(stderr, "binary profile is too small to contain a header\n");
+
+        close(fd);
+
+        return 1;
+    }
+
+    void* map = mmap(NULL, file_len, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    // the mapping keeps its own reference to the file
+    close(fd);
+
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "failed to map binary profile. %s\n", strerror(errno));
+
+        return 1;
+    }
+
+    struct profile_header header;
+
+    memcpy(&header, map, sizeof(header));
+
+    uint32_t version = swap_u32(header.version);
+    uint32_t header_size = swap_u32(header.header_size);
+    uint64_t len = swap_u64(header.len);
+
+    if (memcmp(header.magic, PROFILE_MAGIC, PROFILE_MAGIC_LEN) != 0 || version != PROFILE_VERSION) {
+        fprintf(stderr, "unknown binary profile format. version: %u\n", version);
+
+        munmap(map, file_len);
+
+        return 1;
+    }
+
+    if (header_size < sizeof(header) || header_size % sizeof(double) != 0 || header_size > file_len) {
+        fprintf(stderr, "invalid binary profile header size. size: %u\n", header_size);
+
+        munmap(map, file_len);
+
+        return 1;
+    }
+
+    // the header size is known to fit in the file so the payload is exactly
+    // the samples it claims to hold
+    if (len > INT32_MAX || len * sizeof(double) != file_len - header_size) {
+        fprintf(
+            stderr,
+            "binary profile length does not match file size. len: %lu size: %lu\n",
+            (unsigned long)len,
+            (unsigned long)file_len
+        );
+
+        munmap(map, file_len);
+
+        return 1;
+    }
+
+    // the table is read front to back during each pass. the advice values are
+    // not flags so each one is given on its own
+    madvise(map, file_len, MADV_SEQUENTIAL);
+    madvise(map, file_len, MADV_WILLNEED);
+
+    profile->map = map;
+    profile->map_len = file_len;
+    profile->sample_rate = swap_f64(header.sample_rate);
+    profile->lut.len = (int32_t)len;
+    profile->load_bytes = file_len;
+
+#if PROFILE_SWAP_BYTES
+    // big-endian hosts cannot use the samples in place so they are swapped
+    // into a private copy
+    profile->owned = (double*)malloc(len * sizeof(double));
+
+    if (profile->owned == NULL) {
+        fprintf(stderr, "failed allocating profile lookup table. %s\n", strerror(errno));
+
+        profile_free(profile);
+
+        return 1;
+    }
+
+    const double* samples = (const double*)((const char*)map + header_size);
+
+    for (uint64_t index = 0; index < len; index += 1) {
+        profile->owned[index] = swap_f64(samples[index]);
+    }
+
+    profile->lut.lut = profile->owned;
+#else
+    profile->lut.lut = (double*)((char*)map + header_size);
+#endif
+
+    return 0;
+}
+
+// streams the csv file through a fixed size read buffer, parsing values
+// directly into the spare capacity of a growing lookup table
+int32_t profile_load_csv(const char* file_path, struct profile* profile) {
+    profile_init(profile);
+
+    struct csv_reader reader;
+
+    if (csv_reader_open(&reader, file_path, CSV_BUFFER_SIZE) != 0) {
+        return 1;
+    }
+
+    size_t capacity = 1 << 16;
+    size_t len = 0;
+    double* values = (double*)malloc(capacity * sizeof(double));
+
+    if (values == NULL) {
+        fprintf(stderr, "failed allocating csv lookup table. %s\n", strerror(errno));
+
+        csv_reader_close(&reader);
+
+        return 1;
+    }
+
+    while (1) {
+        if (len == capacity) {
+            capacity *= 2;
+
+            double* grown = (double*)realloc(values, capacity * sizeof(double));
+
+            if (grown == NULL) {
+                fprintf(stderr, "failed growing csv lookup table. %s\n", strerror(errno));
+
+                free(values);
+                csv_reader_close(&reader);
+
+                return 1;
+            }
+
+            values = grown;
+        }
+
+        size_t count = 0;
+
+        if (csv_reader_next(&reader, values + len, capacity - len, &count) != 0) {
+            free(values);
+            csv_reader_close(&reader);
+
+            return 1;
+        }
+
+        if (count == 0) {
+            break;
+        }
+
+        len += count;
+    }
+
+    profile->load_bytes = reader.bytes;
+
+    csv_reader_close(&reader);
+
+    if (len > INT32_MAX) {
+        fprintf(stderr, "csv file contains too many entries. %lu\n", (unsigned long)len);
+
+        free(values);
+
+        return 1;
+    }
+
+    profile->owned = values;
+    profile->lut.len = (int32_t)len;
+    profile->lut.lut = values;
+
+    return 0;
+}
+
+int32_t profile_write_binary(const char* file_path, struct lut_info* lut, double sample_rate) {
+    FILE* file = fopen(file_path, "wb");
+
+    if (file == NULL) {
+        fprintf(stderr, "failed to create binary profile \"%s\". %s\n", file_path, strerror(errno));
+
+        return 1;
+    }
+
+    struct profile_header header;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, PROFILE_MAGIC, PROFILE_MAGIC_LEN);
+    header.version = swap_u32(PROFILE_VERSION);
+    header.header_size = swap_u32(sizeof(header));
+    header.len = swap_u64((uint64_t)lut->len);
+    header.sample_rate = swap_f64(sample_rate);
+
+    int32_t result = 0;
+
+    if (fwrite(&header, sizeof(header), 1, file) != 1) {
+        result = 1;
+    }
+
+#if PROFILE_SWAP_BYTES
+    for (int32_t index = 0; result == 0 && index < lut->len; index += 1) {
+        double value = swap_f64(lut->lut[index]);
+
+        if (fwrite(&value, sizeof(value), 1, file) != 1) {
+            result = 1;
+        }
+    }
+#else
+    if (result == 0 && fwrite(lut->lut, sizeof(double), lut->len, file) != (size_t)lut->len) {
+        result = 1;
+    }
+#endif
+
+    if (fclose(file) != 0) {
+        result = 1;
+    }
+
+    if (result != 0) {
+        fprintf(stderr, "failed writing binary profile \"%s\". %s\n", file_path, strerror(errno));
+    }
+
+    return result;
+}
@@ -0,0 +1,56 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "summation.h"
+
+// 8 byte identifier at the start of every binary profile file
+#define PROFILE_MAGIC "TSIMACC\0"
+#define PROFILE_MAGIC_LEN 8
+#define PROFILE_VERSION 1
+
+// on disk header for binary acceleration profiles. all fields are stored
+// little-endian and the header is padded to a multiple of 8 bytes so the
+// samples that follow it are properly aligned for doubles when mapped.
+//
+// | magic (8) | version (4) | header_size (4) | len (8) | sample_rate (8) |
+// | len * double samples ...                                              |
+struct profile_header {
+    char magic[PROFILE_MAGIC_LEN];
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t len;
+    double sample_rate;
+};
+
+// an acceleration profile loaded from disk. the lut will either point into
+// a memory mapping of a binary profile or into a heap buffer owned by the
+// profile when it had to be parsed.
+struct profile {
+    struct lut_info lut;
+    double sample_rate;
+
+    void* map;
+    size_t map_len;
+
+    double* owned;
+
+    // the number of bytes read from disk and how long it took
+    uint64_t load_bytes;
+    struct timespec load_time;
+};
+
+void profile_init(struct profile* self);
+void profile_free(struct profile* self);
+void profile_print_load(struct profile* self);
+
+int32_t profile_load(const char* file_path, struct profile* profile);
+int32_t profile_load_binary(const char* file_path, struct profile* profile);
+int32_t profile_load_csv(const char* file_path, struct profile* profile);
+
+int32_t profile_write_binary(const char* file_path, struct lut_info* lut, double sample_rate);
+
+#endif
@@ -0,0 +1,161 @@
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "context.h"
+#include "kernels.h"
+#include "segments.h"
+
+void lut_segments_init(struct lut_segments* self) {
+    self->runs = NULL;
+    self->count = 0;
+    self->capacity = 0;
+    self->len = 0;
+}
+
+void lut_segments_free(struct lut_segments* self) {
+    free(self->runs);
+
+    lut_segments_init(self);
+}
+
+static int32_t lut_segments_push(struct lut_segments* self, struct lut_run* run) {
+    if (self->count == self->capacity) {
+        int32_t capacity = self->capacity == 0 ? 64 : self->capacity * 2;
+        struct lut_run* grown = (struct lut_run*)realloc(
+            self->runs,
+            (size_t)capacity * sizeof(struct lut_run)
+        );
+
+        if (grown == NULL) {
+            fprintf(stderr, "failed growing lut segments. %s\n", strerror(errno));
+
+            return 1;
+        }
+
+        self->runs = grown;
+        self->capacity = capacity;
+    }
+
+    self->runs[self->count] = *run;
+    self->count += 1;
+
+    return 0;
+}
+
+// splits the table into maximal linear runs. each run takes its slope from
+// its first interval and is extended for as long as the next entry is within
+// the tolerance of the line through the start of the run.
+int32_t lut_segments_build(struct lut_segments* self, struct lut_info* lut, double tolerance) {
+    lut_segments_free(self);
+
+    if (lut->len < 2) {
+        fprintf(stderr, "acceleration profile must contain at least 2 entries\n");
+
+        return 1;
+    }
+
+    const double* values = lut->lut;
+    int32_t start = 0;
+
+    while (start < lut->len - 1) {
+        struct lut_run run;
+        run.y0 = values[start];
+        run.slope = values[start + 1] - values[start];
+        run.length = 1;
+
+        while (start + run.length + 1 < lut->len) {
+            double expected = run.y0 + (double)(run.length + 1) * run.slope;
+            double diff = values[start + run.length + 1] - expected;
+
+            if ((diff < 0.0 ? -diff : diff) > tolerance) {
+                break;
+            }
+
+            run.length += 1;
+        }
+
+        if (lut_segments_push(self, &run) != 0) {
+            lut_segments_free(self);
+
+            return 1;
+        }
+
+        start += run.length;
+    }
+
+    self->len = lut->len;
+
+    // the runs usually take a fraction of the space they were reserved with
+    struct lut_run* shrunk = (struct lut_run*)realloc(
+        self->runs,
+        (size_t)self->count * sizeof(struct lut_run)
+    );
+
+    if (shrunk != NULL) {
+        self->runs = shrunk;
+        self->capacity = self->count;
+    }
+
+    return 0;
+}
+
+size_t lut_segments_bytes(const struct lut_segments* self) {
+    return (size_t)self->count * sizeof(struct lut_run);
+}
+
+// integrates every run in closed form. every kernel is linear in the
+// acceleration so the velocity gained over interval k of a run is
+//
+//   I_k = A + B * k
+//
+// and, given the velocity V_k at its start, the position gained over it is
+//
+//   P_k = q0 * V_k + C + D * k
+//
+// where q0 and the coefficients only depend on the kernel, the start of the
+// run and its slope. they are found by running the kernel over single
+// intervals so the result matches what the kernel would give over the whole
+// table up to rounding. summing over the n intervals of the run gives
+//
+//   dV = n * A + B * n (n - 1) / 2
+//   dX = q0 * (n * V_0 + A * n (n - 1) / 2 + B * n (n - 1) (n - 2) / 6)
+//      + n * C + D * n (n - 1) / 2
+void lut_segments_run(
+    const struct lut_segments* self,
+    const struct lut_kernel* kernel,
+    int32_t step,
+    struct sim_result* result
+) {
+    struct lut_interval_coeffs coeffs;
+
+    lut_interval_coeffs(kernel, step, &coeffs);
+
+    double i0 = coeffs.i0;
+    double i1 = coeffs.i1;
+    double q0 = coeffs.q0;
+    double j0 = coeffs.j0;
+    double j1 = coeffs.j1;
+
+    double vel = 0.0;
+    double pos = 0.0;
+
+    for (int32_t index = 0; index < self->count; index += 1) {
+        const struct lut_run* run = &self->runs[index];
+        double n = (double)run->length;
+        double a = i0 * run->y0 + i1 * run->slope;
+        double b = i0 * run->slope;
+        double c = j0 * run->y0 + j1 * run->slope;
+        double d = j0 * run->slope;
+        double pairs = n * (n - 1.0) / 2.0;
+        double triples = pairs * (n - 2.0) / 3.0;
+
+        pos += q0 * (n * vel + a * pairs + b * triples) + n * c + d * pairs;
+        vel += n * a + b * pairs;
+    }
+
+    result->velocity = vel;
+    result->position = pos;
+}
@@ -0,0 +1,46 @@
+#ifndef SEGMENTS_H
+#define SEGMENTS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "context.h"
+#include "kernels.h"
+#include "summation.h"
+
+// a maximal stretch of the table where the acceleration is linear. a run
+// starts at the entry where the one before it ended, which is the sum of the
+// lengths before it, and the entries start through start + length are
+// y0 + k * slope for k in [0, length]. packed so a run takes 20 bytes
+// instead of 24.
+struct lut_run {
+    double y0;
+    double slope;
+    int32_t length;
+} __attribute__((packed));
+
+// a lookup table stored as the linear runs it is made of instead of one double
+// per entry. profiles that are mostly constant acceleration and linear ramps
+// only need a handful of runs.
+struct lut_segments {
+    struct lut_run* runs;
+    int32_t count;
+    int32_t capacity;
+    // the number of entries of the table the runs were built from
+    int32_t len;
+};
+
+void lut_segments_init(struct lut_segments* self);
+void lut_segments_free(struct lut_segments* self);
+
+int32_t lut_segments_build(struct lut_segments* self, struct lut_info* lut, double tolerance);
+size_t lut_segments_bytes(const struct lut_segments* self);
+
+void lut_segments_run(
+    const struct lut_segments* self,
+    const struct lut_kernel* kernel,
+    int32_t step,
+    struct sim_result* result
+);
+
+#endif
@@ -0,0 +1,760 @@
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "args.h"
+#include "context.h"
+#include "kernels.h"
+#include "profile.h"
+#include "server.h"
+#include "trajectory.h"
+
+// a long running process that answers where a train is at a given time. each
+// (file, algo, step) is simulated once into the state at every entry of its
+// profile, after which a query is a lookup of the interval holding the time
+// and an interpolation inside of it.
+//
+// requests are lines of text over a unix socket, each answered with a line
+// starting with ok or err
+//
+//   at <FILE> <ALGO> <STEP> <TIME>...            ok <VEL> <POS>...
+//   range <FILE> <ALGO> <STEP> <FROM> <TO> <N>   ok <N> then N lines of
+//                                                <TIME> <VEL> <POS>
+//   stats                                        ok <counters>
+//   quit                                         closes the connection
+//
+// times are in entries of the profile, the same as the time of a trajectory.
+
+static volatile sig_atomic_t server_stop = 0;
+
+static void server_signal(int signal) {
+    (void)signal;
+
+    server_stop = 1;
+}
+
+int32_t sim_cache_init(struct sim_cache* self, struct sim_args* args, size_t capacity) {
+    self->head = NULL;
+    self->tail = NULL;
+    self->entries = 0;
+    self->bytes = 0;
+    self->capacity = capacity;
+    self->hits = 0;
+    self->misses = 0;
+    self->joins = 0;
+    self->evictions = 0;
+    self->oversized = 0;
+    self->stale = 0;
+    self->args = *args;
+
+    if (pthread_mutex_init(&self->lock, NULL) != 0) {
+        fprintf(stderr, "failed creating cache lock\n");
+
+        return 1;
+    }
+
+    if (pthread_cond_init(&self->cond, NULL) != 0) {
+        fprintf(stderr, "failed creating cache condition\n");
+
+        pthread_mutex_destroy(&self->lock);
+
+        return 1;
+    }
+
+    return 0;
+}
+
+static void cache_entry_free(struct cache_entry* entry) {
+    free(entry->file_path);
+    free(entry->samples);
+    free(entry);
+}
+
+void sim_cache_free(struct sim_cache* self) {
+    struct cache_entry* iter = self->head;
+
+    while (iter != NULL) {
+        struct cache_entry* next = iter->next;
+
+        cache_entry_free(iter);
+
+        iter = next;
+    }
+
+    pthread_cond_destroy(&self->cond);
+    pthread_mutex_destroy(&self->lock);
+}
+
+// the list helpers expect the cache lock to be held
+static void sim_cache_unlink(struct sim_cache* self, struct cache_entry* entry) {
+    if (entry->prev != NULL) {
+        entry->prev->next = entry->next;
+    } else {
+        self->head = entry->next;
+    }
+
+    if (entry->next != NULL) {
+        entry->next->prev = entry->prev;
+    } else {
+        self->tail = entry->prev;
+    }
+
+    entry->prev = NULL;
+    entry->next = NULL;
+    entry->linked = 0;
+
+    self->entries -= 1;
+    self->bytes -= entry->bytes;
+}
+
+static void sim_cache_push(struct sim_cache* self, struct cache_entry* entry) {
+    entry->prev = NULL;
+    entry->next = self->head;
+
+    if (self->head != NULL) {
+        self->head->prev = entry;
+    } else {
+        self->tail = entry;
+    }
+
+    self->head = entry;
+    entry->linked = 1;
+
+    self->entries += 1;
+    self->bytes += entry->bytes;
+}
+
+// drops the least recently used entries that nothing is reading until the
+// cache fits in its capacity
+static void sim_cache_evict(struct sim_cache* self) {
+    struct cache_entry* iter = self->tail;
+
+    while (iter != NULL && self->bytes > self->capacity) {
+        struct cache_entry* prev = iter->prev;
+
+        if (iter->state == CACHE_READY && iter->refs == 0) {
+            sim_cache_unlink(self, iter);
+            cache_entry_free(iter);
+
+            self->evictions += 1;
+        }
+
+        iter = prev;
+    }
+}
+
+static struct cache_entry* sim_cache_find(struct sim_cache* self, const struct stat* info, int32_t algo, int32_t step) {
+    for (struct cache_entry* iter = self->head; iter != NULL; iter = iter->next) {
+        if (iter->algo == algo && iter->step == step && iter->dev == info->st_dev && iter->ino == info->st_ino) {
+            return iter;
+        }
+    }
+
+    return NULL;
+}
+
+static int32_t cache_entry_current(const struct cache_entry* entry, const struct stat* info) {
+    return entry->size == info->st_size &&
+        entry->mtime.tv_sec == info->st_mtim.tv_sec &&
+        entry->mtime.tv_nsec == info->st_mtim.tv_nsec;
+}
+
+// simulates the profile into the samples of the entry without holding the
+// cache lock
+static int32_t cache_entry_compute(struct cache_entry* entry, struct sim_args* defaults) {
+    struct profile profile;
+    profile_init(&profile);
+
+    if (profile_load(entry->file_path, &profile) != 0) {
+        return 1;
+    }
+
+    if (profile.lut.len < 2) {
+        fprintf(stderr, "acceleration profile must contain at least 2 entries. %s\n", entry->file_path);
+
+        profile_free(&profile);
+
+        return 1;
+    }
+
+    struct sim_args args = *defaults;
+    args.algo = entry->algo;
+    args.step = entry->step;
+
+    struct sim_context context;
+
+    if (sim_context_init(&context, &args, 0) != 0) {
+        sim_context_free(&context);
+        profile_free(&profile);
+
+        return 1;
+    }
+
+    size_t bytes = (size_t)profile.lut.len * sizeof(struct trajectory_sample);
+    struct trajectory_sample* samples = (struct trajectory_sample*)malloc(bytes);
+    struct sim_result result;
+    int32_t rtn = 1;
+
+    if (samples == NULL) {
+        fprintf(stderr, "failed allocating cached trajectory. %s\n", strerror(errno));
+    } else if (sim_context_samples(&context, &profile.lut, samples, &result) == 0) {
+        entry->samples = samples;
+        entry->len = profile.lut.len;
+
+        rtn = 0;
+    } else {
+        free(samples);
+    }
+
+    sim_context_free(&context);
+    profile_free(&profile);
+
+    return rtn;
+}
+
+// returns the entry for the key with a reference that has to be released,
+// or NULL when it could not be computed. the first request for a key computes
+// it and every request that arrives in the mean time waits for that result
+// instead of starting its own.
+struct cache_entry* sim_cache_acquire(struct sim_cache* self, const char* file_path, int32_t algo, int32_t step) {
+    struct stat info;
+
+    if (stat(file_path, &info) != 0) {
+        fprintf(stderr, "failed to stat data file \"%s\". %s\n", file_path, strerror(errno));
+
+        return NULL;
+    }
+
+    pthread_mutex_lock(&self->lock);
+
+    struct cache_entry* entry = sim_cache_find(self, &info, algo, step);
+
+    // the file changed since the entry was computed. the requests still
+    // reading it keep it alive until they release it
+    if (entry != NULL && !cache_entry_current(entry, &info)) {
+        sim_cache_unlink(self, entry);
+
+        if (entry->refs == 0) {
+            cache_entry_free(entry);
+        }
+
+        self->stale += 1;
+
+        entry = NULL;
+    }
+
+    if (entry != NULL) {
+        entry->refs += 1;
+
+        if (entry->state == CACHE_LOADING) {
+            self->joins += 1;
+
+            while (entry->state == CACHE_LOADING) {
+                pthread_cond_wait(&self->cond, &self->lock);
+            }
+        } else {
+            self->hits += 1;
+        }
+
+        if (entry->state == CACHE_FAILED) {
+            entry->refs -= 1;
+
+            if (entry->refs == 0) {
+                cache_entry_free(entry);
+            }
+
+            entry = NULL;
+        } else if (entry->linked) {
+            sim_cache_unlink(self, entry);
+            sim_cache_push(self, entry);
+        }
+
+        pthread_mutex_unlock(&self->lock);
+
+        return entry;
+    }
+
+    self->misses += 1;
+
+    entry = (struct cache_entry*)calloc(1, sizeof(struct cache_entry));
+
+    if (entry == NULL || (entry->file_path = strdup(file_path)) == NULL) {
+        fprintf(stderr, "failed allocating cache entry. %s\n", strerror(errno));
+
+        free(entry);
+
+        pthread_mutex_unlock(&self->lock);
+
+        return NULL;
+    }
+
+    entry->algo = algo;
+    entry->step = step;
+    entry->dev = info.st_dev;
+    entry->ino = info.st_ino;
+    entry->mtime = info.st_mtim;
+    entry->size = info.st_size;
+    entry->state = CACHE_LOADING;
+    entry->refs = 1;
+
+    sim_cache_push(self, entry);
+
+    pthread_mutex_unlock(&self->lock);
+
+    int32_t rtn = cache_entry_compute(entry, &self->args);
+
+    pthread_mutex_lock(&self->lock);
+
+    if (rtn == 0) {
+        entry->state = CACHE_READY;
+
+        // the size is only known once the entry is computed. an entry that
+        // would not fit even on its own is not admitted, otherwise it would
+        // evict every other entry and then be dropped itself once released.
+        // it stays unlinked for the requests that are waiting on it
+        if ((size_t)entry->len * sizeof(struct trajectory_sample) > self->capacity) {
+            if (entry->linked) {
+                sim_cache_unlink(self, entry);
+            }
+
+            self->oversized += 1;
+        } else if (entry->linked) {
+            entry->bytes = (size_t)entry->len * sizeof(struct trajectory_sample);
+
+            self->bytes += entry->bytes;
+
+            sim_cache_evict(self);
+        }
+    } else {
+        // failures are not cached so the next request tries again
+        if (entry->linked) {
+            sim_cache_unlink(self, entry);
+        }
+
+        entry->state = CACHE_FAILED;
+        entry->refs -= 1;
+
+        if (entry->refs == 0) {
+            cache_entry_free(entry);
+        }
+
+        entry = NULL;
+    }
+
+    pthread_cond_broadcast(&self->cond);
+    pthread_mutex_unlock(&self->lock);
+
+    return entry;
+}
+
+void sim_cache_release(struct sim_cache* self, struct cache_entry* entry) {
+    pthread_mutex_lock(&self->lock);
+
+    entry->refs -= 1;
+
+    if (!entry->linked && entry->refs == 0) {
+        cache_entry_free(entry);
+    } else {
+        sim_cache_evict(self);
+    }
+
+    pthread_mutex_unlock(&self->lock);
+}
+
+// the state at a time inside of [0, len - 1]. the velocity is interpolated
+// linearly and the position with the cubic hermite through the positions and
+// velocities at either end of the interval, so the position is smooth and
+// matches the simulation at every entry.
+void cache_entry_at(const struct cache_entry* self, double time, double* vel, double* pos) {
+    int32_t index = (int32_t)time;
+
+    if (index >= self->len - 1) {
+        *vel = self->samples[self->len - 1].vel;
+        *pos = self->samples[self->len - 1].pos;
+
+        return;
+    }
+
+    const struct trajectory_sample* lower = &self->samples[index];
+    const struct trajectory_sample* upper = lower + 1;
+    double t = time - (double)index;
+    double t2 = t * t;
+    double t3 = t2 * t;
+
+    *vel = lower->vel + t * (upper->vel - lower->vel);
+    *pos = (2.0 * t3 - 3.0 * t2 + 1.0) * lower->pos +
+        (t3 - 2.0 * t2 + t) * lower->vel +
+        (-2.0 * t3 + 3.0 * t2) * upper->pos +
+        (t3 - t2) * upper->vel;
+}
+
+static int32_t parse_time(const char* arg, const struct cache_entry* entry, double* time) {
+    char* end = NULL;
+
+    errno = 0;
+    *time = strtod(arg, &end);
+
+    if (errno != 0 || end == arg || *end != '\0' || !(*time >= 0.0 && *time <= (double)(entry->len - 1))) {
+        return 1;
+    }
+
+    return 0;
+}
+
+// parses the file, algo and step every query starts with and acquires the
+// entry for them
+static struct cache_entry* server_acquire(struct sim_cache* cache, char** save, FILE* out) {
+    char* file_path = strtok_r(NULL, " \t", save);
+    char* algo_arg = strtok_r(NULL, " \t", save);
+    char* step_arg = strtok_r(NULL, " \t", save);
+    int32_t algo;
+    int32_t step;
+
+    if (file_path == NULL || algo_arg == NULL || step_arg == NULL) {
+        fprintf(out, "err expected <FILE> <ALGO> <STEP>\n");
+
+        return NULL;
+    }
+
+    if (args_parse_algo(algo_arg, &algo) != 0 || args_parse_step(step_arg, &step) != 0) {
+        fprintf(out, "err invalid algo or step\n");
+
+        return NULL;
+    }
+
+    struct cache_entry* entry = sim_cache_acquire(cache, file_path, algo, step);
+
+    if (entry == NULL) {
+        fprintf(out, "err failed simulating %s\n", file_path);
+    }
+
+    return entry;
+}
+
+static void server_at(struct sim_cache* cache, char** save, FILE* out) {
+    struct cache_entry* entry = server_acquire(cache, save, out);
+
+    if (entry == NULL) {
+        return;
+    }
+
+    // every time is checked before anything is written so an error is the
+    // only thing on the line. a request line holds at most half as many
+    // times as it has characters.
+    double times[SERVER_LINE_LEN / 2];
+    int32_t count = 0;
+
+    for (char* arg = strtok_r(NULL, " \t", save); arg != NULL; arg = strtok_r(NULL, " \t", save)) {
+        if (parse_time(arg, entry, &times[count]) != 0) {
+            fprintf(out, "err invalid time %s for %d entries\n", arg, entry->len);
+
+            sim_cache_release(cache, entry);
+
+            return;
+        }
+
+        count += 1;
+    }
+
+    if (count == 0) {
+        fprintf(out, "err expected at least one <TIME>\n");
+
+        sim_cache_release(cache, entry);
+
+        return;
+    }
+
+    fputs("ok", out);
+
+    for (int32_t index = 0; index < count; index += 1) {
+        double vel;
+        double pos;
+
+        cache_entry_at(entry, times[index], &vel, &pos);
+
+        fprintf(out, " %.15lf %.15lf", vel, pos);
+    }
+
+    fputc('\n', out);
+
+    sim_cache_release(cache, entry);
+}
+
+static void server_range(struct sim_cache* cache, char** save, FILE* out) {
+    struct cache_entry* entry = server_acquire(cache, save, out);
+
+    if (entry == NULL) {
+        return;
+    }
+
+    char* from_arg = strtok_r(NULL, " \t", save);
+    char* to_arg = strtok_r(NULL, " \t", save);
+    char* count_arg = strtok_r(NULL, " \t", save);
+    double from;
+    double to;
+    char* end = NULL;
+    long count = 0;
+
+    if (count_arg != NULL) {
+        count = strtol(count_arg, &end, 10);
+    }
+
+    if (
+        count_arg == NULL ||
+        parse_time(from_arg, entry, &from) != 0 ||
+        parse_time(to_arg, entry, &to) != 0 ||
+        *end != '\0' ||
+        count < 1 ||
+        count > SERVER_MAX_RANGE
+    ) {
+        fprintf(out, "err expected <FROM> <TO> <N> inside of %d entries and N up to %d\n", entry->len, SERVER_MAX_RANGE);
+
+        sim_cache_release(cache, entry);
+
+        return;
+    }
+
+    fprintf(out, "ok %ld\n", count);
+
+    for (long point = 0; point < count; point += 1) {
+        double time = count == 1 ? from : from + (to - from) * (double)point / (double)(count - 1);
+        double vel;
+        double pos;
+
+        cache_entry_at(entry, time, &vel, &pos);
+
+        fprintf(out, "%.9lf %.15lf %.15lf\n", time, vel, pos);
+    }
+
+    sim_cache_release(cache, entry);
+}
+
+static void server_stats(struct sim_cache* cache, FILE* out) {
+    pthread_mutex_lock(&cache->lock);
+
+    fprintf(
+        out,
+        "ok entries: %d bytes: %lu capacity: %lu hits: %lu misses: %lu joins: %lu evictions: %lu "
+        "oversized: %lu stale: %lu\n",
+        cache->entries,
+        (unsigned long)cache->bytes,
+        (unsigned long)cache->capacity,
+        (unsigned long)cache->hits,
+        (unsigned long)cache->misses,
+        (unsigned long)cache->joins,
+        (unsigned long)cache->evictions,
+        (unsigned long)cache->oversized,
+        (unsigned long)cache->stale
+    );
+
+    pthread_mutex_unlock(&cache->lock);
+}
+
+struct server_conn {
+    int fd;
+    struct sim_cache* cache;
+};
+
+// answers the requests of a single connection until it is closed
+static void* server_conn_run(void* arg) {
+    struct server_conn* conn = (struct server_conn*)arg;
+    struct sim_cache* cache = conn->cache;
+    int write_fd = dup(conn->fd);
+    FILE* in = fdopen(conn->fd, "r");
+    FILE* out = write_fd >= 0 ? fdopen(write_fd, "w") : NULL;
+
+    free(conn);
+
+    if (in == NULL || out == NULL) {
+        fprintf(stderr, "failed opening connection streams. %s\n", strerror(errno));
+
+        if (in != NULL) {
+            fclose(in);
+        }
+
+        if (out != NULL) {
+            fclose(out);
+        } else if (write_fd >= 0) {
+            close(write_fd);
+        }
+
+        return NULL;
+    }
+
+    char line[SERVER_LINE_LEN];
+
+    while (fgets(line, sizeof(line), in) != NULL) {
+        // a line that does not fit is dropped up to its newline so the rest
+        // of it is not read as another request
+        if (strchr(line, '\n') == NULL && !feof(in)) {
+            int ch = fgetc(in);
+
+            if (ch != '\n' && ch != EOF) {
+                while (ch != '\n' && ch != EOF) {
+                    ch = fgetc(in);
+                }
+
+                fprintf(out, "err line too long\n");
+
+                if (fflush(out) != 0) {
+                    break;
+                }
+
+                continue;
+            }
+        }
+
+        line[strcspn(line, "\r\n")] = '\0';
+
+        char* save = NULL;
+        char* command = strtok_r(line, " \t", &save);
+
+        if (command == NULL) {
+            continue;
+        }
+
+        if (strcmp(command, "at") == 0) {
+            server_at(cache, &save, out);
+        } else if (strcmp(command, "range") == 0) {
+            server_range(cache, &save, out);
+        } else if (strcmp(command, "stats") == 0) {
+            server_stats(cache, out);
+        } else if (strcmp(command, "quit") == 0) {
+            break;
+        } else {
+            fprintf(out, "err unknown command %s\n", command);
+        }
+
+        if (fflush(out) != 0) {
+            break;
+        }
+    }
+
+    fclose(in);
+    fclose(out);
+
+    return NULL;
+}
+
+// listens on the unix socket until interrupted, answering each connection
+// from its own thread against the shared cache
+int32_t server_run(struct sim_args* args, const char* socket_path, size_t cache_bytes) {
+    struct sockaddr_un addr;
+
+    if (strlen(socket_path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "socket path is too long \"%s\"\n", socket_path);
+
+        return 1;
+    }
+
+    struct sim_cache cache;
+
+    if (sim_cache_init(&cache, args, cache_bytes) != 0) {
+        return 1;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (fd < 0) {
+        fprintf(stderr, "failed creating socket. %s\n", strerror(errno));
+
+        sim_cache_free(&cache);
+
+        return 1;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, socket_path);
+
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 64) != 0) {
+        fprintf(
+            stderr,
+            "failed listening on \"%s\", remove it if no server is running. %s\n",
+            socket_path,
+            strerror(errno)
+        );
+
+        close(fd);
+        sim_cache_free(&cache);
+
+        return 1;
+    }
+
+    // the accept below has to be interrupted by the signals so they are
+    // installed without SA_RESTART
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    sigemptyset(&action.sa_mask);
+    action.sa_handler = server_signal;
+
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    // a client closing early should only end its own connection
+    signal(SIGPIPE, SIG_IGN);
+
+    printf("listening: %s cache: %lu bytes\n", socket_path, (unsigned long)cache_bytes);
+    fflush(stdout);
+
+    int32_t rtn = 0;
+
+    while (!server_stop) {
+        int client = accept(fd, NULL, NULL);
+
+        if (client < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+
+            fprintf(stderr, "failed accepting connection. %s\n", strerror(errno));
+
+            rtn = 1;
+
+            break;
+        }
+
+        struct server_conn* conn = (struct server_conn*)malloc(sizeof(struct server_conn));
+        pthread_t thread;
+
+        if (conn == NULL) {
+            fprintf(stderr, "failed allocating connection. %s\n", strerror(errno));
+
+            close(client);
+
+            continue;
+        }
+
+        conn->fd = client;
+        conn->cache = &cache;
+
+        if (pthread_create(&thread, NULL, server_conn_run, conn) != 0) {
+            fprintf(stderr, "failed starting connection thread\n");
+
+            close(client);
+            free(conn);
+
+            continue;
+        }
+
+        pthread_detach(thread);
+    }
+
+    close(fd);
+    unlink(socket_path);
+
+    server_stats(&cache, stdout);
+
+    // connection threads may still be using the cache so it is left for the
+    // process exit to release
+    return rtn;
+}
@@ -0,0 +1,90 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "args.h"
+#include "trajectory.h"
+
+// the most points a single range query returns
+#define SERVER_MAX_RANGE 100000
+// the longest request line
+#define SERVER_LINE_LEN 4096
+
+enum CACHE_STATE {
+    CACHE_LOADING = 0,
+    CACHE_READY = 1,
+    CACHE_FAILED = 2
+};
+
+// the state at every entry of a profile simulated with a single algo and
+// step. the entry is only filled in by the request that created it and every
+// other request for the same key waits for that one computation to finish.
+struct cache_entry {
+    char* file_path;
+    int32_t algo;
+    int32_t step;
+
+    // the file is keyed on its device and inode so every spelling of its path
+    // shares an entry. the modification time and size are checked on every
+    // hit so an entry of a file that was rewritten is simulated again
+    dev_t dev;
+    ino_t ino;
+    struct timespec mtime;
+    off_t size;
+
+    struct trajectory_sample* samples;
+    int32_t len;
+    size_t bytes;
+
+    int32_t state;
+    // the requests using or waiting on the entry. it is only freed once it has
+    // been evicted or has failed and nothing references it
+    int32_t refs;
+    int32_t linked;
+
+    // least recently used order, the head is the most recently used
+    struct cache_entry* prev;
+    struct cache_entry* next;
+};
+
+struct sim_cache {
+    struct cache_entry* head;
+    struct cache_entry* tail;
+    int32_t entries;
+    size_t bytes;
+    size_t capacity;
+
+    uint64_t hits;
+    uint64_t misses;
+    // requests that arrived while their entry was being computed
+    uint64_t joins;
+    uint64_t evictions;
+    // entries larger than the whole capacity that were only kept for the
+    // requests that asked for them
+    uint64_t oversized;
+    // entries dropped because their file changed since they were computed
+    uint64_t stale;
+
+    // the threads and isa every computation is run with
+    struct sim_args args;
+
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+};
+
+int32_t sim_cache_init(struct sim_cache* self, struct sim_args* args, size_t capacity);
+void sim_cache_free(struct sim_cache* self);
+
+struct cache_entry* sim_cache_acquire(struct sim_cache* self, const char* file_path, int32_t algo, int32_t step);
+void sim_cache_release(struct sim_cache* self, struct cache_entry* entry);
+
+void cache_entry_at(const struct cache_entry* self, double time, double* vel, double* pos);
+
+int32_t server_run(struct sim_args* args, const char* socket_path, size_t cache_bytes);
+
+#endif
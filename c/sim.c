@@ -4,6 +4,7 @@
 
 #include <errno.h>
 #include <limits.h>
+#include <math.h>
 #include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -15,266 +16,854 @@
 #include "sim.h"
 #include "ts.h"
 #include "args.h"
+#include "batch.h"
+#include "context.h"
+#include "fleet.h"
+#include "incremental.h"
+#include "kernels.h"
+#include "offload.h"
+#include "position_index.h"
+#include "precision.h"
+#include "segments.h"
+#include "stream.h"
+#include "sweep.h"
 #include "summation.h"
-#include "table_lookup.h"
+#include "trajectory.h"
 
-int main(int argc, char** argv) {
-    struct app_args args;
+// runs the simulation for the requested number of iterations with a single
+// context so the setup is only done once. returns non zero if the simulation
+// or writing the profile failed
+static int32_t run_iterations(struct sim_args* args, struct lut_info* lut) {
+    struct sim_context context;
+
+    if (sim_context_init(&context, args, lut->len) != 0) {
+        sim_context_free(&context);
 
-    if (app_args_init(&args, argc, argv) != 0) {
         return 1;
     }
 
-    /*
-    struct lut_info accel_lut;
-    accel_lut.len = 0;
-    accel_lut.lut = (double*)malloc(accel_lut.len * sizeof(double));
-    */
-    struct lut_info accel_lut;
-    accel_lut.len = TABLE_SIZE;
-    accel_lut.lut = ACCELERATION_DATA;
+    struct sim_result result;
+    result.velocity = 0.0;
+    result.position = 0.0;
+
+    int32_t rtn = sim_context_run_iterations(&context, lut, args->iterations, &result);
+
+    if (rtn == 0) {
+        printf("velocity: %.15lf\n", result.velocity);
+        printf("position: %.15lf\n", result.position);
+    }
+
+    printf("isa: %s\n", lut_kernel_isa_name(lut_kernel_isa()));
+
+    timing_print(&context.time_data);
+    profiler_print(&context.profiler);
+
+    if (args->profile_path != NULL) {
+        int32_t csv = args->profile_format == FORMAT_CSV;
+
+        if (profiler_write(&context.profiler, args->profile_path, csv) != 0) {
+            rtn = 1;
+        }
+    }
+
+    sim_context_free(&context);
+
+    return rtn;
+}
+
+// runs a single simulation over the table without printing anything and
+// stores the final velocity and position in the result. callers that run many
+// simulations should keep a sim_context around instead so the setup is only
+// done once.
+int32_t sim_run(struct sim_args* args, struct lut_info* lut, struct sim_result* result) {
+    struct sim_context context;
 
-    if (args.sim.threads == 1) {
-        run_sim(&args.sim, &accel_lut);
+    if (sim_context_init(&context, args, lut->len) != 0) {
+        sim_context_free(&context);
+
+        return 1;
+    }
+
+    int32_t rtn = sim_context_run(&context, lut, result);
+
+    sim_context_free(&context);
+
+    return rtn;
+}
+
+int32_t sim_run_serial(struct sim_args* args, struct lut_info* lut) {
+    struct sim_args serial = *args;
+    serial.threads = 1;
+
+    return run_iterations(&serial, lut);
+}
+
+int32_t sim_run_openmp(struct sim_args* args, struct lut_info* lut) {
+    return run_iterations(args, lut);
+}
+
+// prints a single combination of a sweep. order is the rate the position
+// error shrinks at compared to the previous step of the same algo and is
+// left out when there is none or an error is zero.
+static void print_sweep_point(
+    const struct sweep_point* point,
+    const struct sweep_point* reference,
+    const struct sweep_point* prev,
+    int32_t format
+) {
+    double vel_error = fabs(point->velocity - reference->velocity);
+    double pos_error = fabs(point->position - reference->position);
+    int32_t has_order = 0;
+    double order = 0.0;
+
+    if (prev != NULL && prev->algo == point->algo && prev->step != point->step) {
+        double prev_error = fabs(prev->position - reference->position);
+
+        if (prev_error > 0.0 && pos_error > 0.0) {
+            order = log(prev_error / pos_error) / log((double)point->step / (double)prev->step);
+            has_order = 1;
+        }
+    }
+
+    const char* name = get_lut_kernel(point->algo)->name;
+
+    if (format == FORMAT_JSON) {
+        printf(
+            "{\"algo\":\"%s\",\"step\":%d,\"velocity\":%.15lf,\"position\":%.15lf,"
+            "\"velocity_error\":%.6e,\"position_error\":%.6e,\"order\":",
+            name,
+            point->step,
+            point->velocity,
+            point->position,
+            vel_error,
+            pos_error
+        );
+
+        if (has_order) {
+            printf("%.4lf}\n", order);
+        } else {
+            printf("null}\n");
+        }
     } else {
-        run_sim_openmp(&args.sim, &accel_lut);
+        printf(
+            "%s,%d,%.15lf,%.15lf,%.6e,%.6e,",
+            name,
+            point->step,
+            point->velocity,
+            point->position,
+            vel_error,
+            pos_error
+        );
+
+        if (has_order) {
+            printf("%.4lf\n", order);
+        } else {
+            printf("\n");
+        }
+    }
+}
+
+// runs every combination of the given algos and steps over the profile in a
+// single pass and prints them with their error against the exact kernel
+int32_t sim_run_sweep(
+    struct sim_args* args,
+    struct lut_info* lut,
+    const int32_t* algos,
+    int32_t algos_len,
+    const int32_t* steps,
+    int32_t steps_len,
+    int32_t format
+) {
+    struct sweep sweep;
+    struct timing time_data;
+    struct timespec start;
+    struct timespec end;
+    struct timespec diff;
+
+    sweep_init(&sweep);
+    timing_init(&time_data);
+
+    if (sweep_build(&sweep, algos, algos_len, steps, steps_len) != 0) {
+        return 1;
+    }
+
+    for (int32_t c = 0; c < args->iterations; c += 1) {
+        clock_gettime(CLOCK_MONOTONIC, &start);
+
+        if (sweep_run(&sweep, lut, args->threads) != 0) {
+            sweep_free(&sweep);
+
+            return 1;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        timespec_diff(&start, &end, &diff);
+        timing_update(&time_data, &diff);
+    }
+
+    const struct sweep_point* reference = &sweep.points[sweep.len - 1];
+
+    if (format == FORMAT_CSV) {
+        printf("algo,step,velocity,position,velocity_error,position_error,order\n");
+    }
+
+    for (int32_t point = 0; point < sweep.len - 1; point += 1) {
+        print_sweep_point(
+            &sweep.points[point],
+            reference,
+            point > 0 ? &sweep.points[point - 1] : NULL,
+            format
+        );
     }
 
+    print_sweep_point(reference, reference, NULL, format);
+
+    printf("combinations: %d entries: %d\n", sweep.len, lut->len);
+    timing_print(&time_data);
+
+    sweep_free(&sweep);
+
     return 0;
 }
 
-void run_sim(struct sim_args* args, struct lut_info* lut) {
+// runs the simulation once and streams the state at every entry of the table
+// to the given file
+int32_t sim_run_trajectory(struct sim_args* args, struct lut_info* lut, const char* file_path, int32_t format) {
+    struct sim_context context;
+
+    if (sim_context_init(&context, args, 0) != 0) {
+        sim_context_free(&context);
+
+        return 1;
+    }
+
+    struct trajectory_writer writer;
+
+    if (trajectory_writer_open(&writer, file_path, format) != 0) {
+        sim_context_free(&context);
+
+        return 1;
+    }
+
+    struct sim_result result;
+    struct timespec start;
+    struct timespec end;
+    struct timespec diff;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    int32_t rtn = sim_context_trajectory(&context, lut, &writer, &result);
+
+    if (trajectory_writer_close(&writer) != 0) {
+        rtn = 1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    timespec_diff(&start, &end, &diff);
+
+    if (rtn == 0) {
+        printf("velocity: %.15lf\n", result.velocity);
+        printf("position: %.15lf\n", result.position);
+        printf("isa: %s\n", lut_kernel_isa_name(lut_kernel_isa()));
+        printf("total: %ld.%.9ld\n", diff.tv_sec, diff.tv_nsec);
+
+        trajectory_writer_print(&writer);
+    }
+
+    sim_context_free(&context);
+
+    return rtn;
+}
+
+// integrates the csv profile chunk by chunk while the reader thread is still
+// parsing the rest of it
+int32_t sim_run_stream(struct sim_args* args, const char* file_path) {
+    struct sim_context context;
+
+    if (sim_context_init(&context, args, 0) != 0) {
+        sim_context_free(&context);
+
+        return 1;
+    }
+
+    struct sim_result result;
+    struct timespec start;
+    struct timespec end;
+    struct timespec diff;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    struct stream_reader reader;
+
+    if (stream_reader_open(&reader, file_path, STREAM_CHUNK_LEN) != 0) {
+        sim_context_free(&context);
+
+        return 1;
+    }
+
+    int32_t rtn = sim_context_stream(&context, &reader, &result);
+
+    if (stream_reader_close(&reader) != 0) {
+        rtn = 1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    timespec_diff(&start, &end, &diff);
+
+    if (rtn == 0) {
+        printf("velocity: %.15lf\n", result.velocity);
+        printf("position: %.15lf\n", result.position);
+        printf("isa: %s\n", lut_kernel_isa_name(lut_kernel_isa()));
+        printf("total: %ld.%.9ld\n", diff.tv_sec, diff.tv_nsec);
+
+        stream_reader_print(&reader);
+    }
+
+    sim_context_free(&context);
+
+    return rtn;
+}
+
+// fits linear runs to the table once and then simulates the runs instead of
+// the table for the requested number of iterations
+int32_t sim_run_compressed(struct sim_args* args, struct lut_info* lut, double tolerance) {
+    struct lut_segments segments;
+    struct timespec start;
+    struct timespec end;
+    struct timespec diff;
+
+    lut_segments_init(&segments);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    if (lut_segments_build(&segments, lut, tolerance) != 0) {
+        return 1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    timespec_diff(&start, &end, &diff);
+
+    size_t table_bytes = (size_t)lut->len * sizeof(double);
+    size_t segment_bytes = lut_segments_bytes(&segments);
+
+    printf(
+        "segments: %d runs %lu bytes from %d entries %lu bytes (%.1lfx) in %ld.%.9ld\n",
+        segments.count,
+        (unsigned long)segment_bytes,
+        lut->len,
+        (unsigned long)table_bytes,
+        (double)table_bytes / (double)segment_bytes,
+        diff.tv_sec,
+        diff.tv_nsec
+    );
+
+    // a table that is not made of long linear runs takes more space as runs
+    // than it does as is, so the table is simulated instead
+    if (segment_bytes >= table_bytes) {
+        fprintf(
+            stderr,
+            "segments do not make the table any smaller. simulating the table instead\n"
+        );
+
+        lut_segments_free(&segments);
+
+        return args->threads == 1 ? sim_run_serial(args, lut) : sim_run_openmp(args, lut);
+    }
+
+    const struct lut_kernel* kernel = get_lut_kernel(args->algo);
     struct timing time_data;
-    struct log_timer log_time;
+    struct sim_result result;
 
     timing_init(&time_data);
-    log_timer_init(&log_time);
 
-    struct lut_info vel_lut;
-    vel_lut.len = lut->len;
-    vel_lut.lut = (double*)malloc(vel_lut.len * sizeof(double));
+    for (int32_t c = 0; c < args->iterations; c += 1) {
+        clock_gettime(CLOCK_MONOTONIC, &start);
 
-    if (vel_lut.lut == NULL) {
-        fprintf(stderr, "failed allocating vel lookup table. %s\n", strerror(errno));
+        lut_segments_run(&segments, kernel, args->step, &result);
 
-        return;
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        timespec_diff(&start, &end, &diff);
+        timing_update(&time_data, &diff);
     }
 
-    vel_lut.lut[0] = 0.0;
+    printf("velocity: %.15lf\n", result.velocity);
+    printf("position: %.15lf\n", result.position);
+    timing_print(&time_data);
+
+    lut_segments_free(&segments);
 
-    summation sum_cb = left_riemann;
+    return 0;
+}
 
-    switch (args->algo) {
-    case LEFT_RIEMANN:
-        break;
-    case MID_RIEMANN:
-        sum_cb = mid_riemann;
-        break;
-    case RIGHT_RIEMANN:
-        sum_cb = right_riemann;
-        break;
-    case TRAPEZOIDAL:
-        sum_cb = trapezoidal;
-        break;
-    case SIMPSONS:
-        sum_cb = simpsons;
-        break;
+// loads every profile of the list into a fleet and simulates them together
+// for the requested number of iterations
+int32_t sim_run_fleet(struct sim_args* args, const char* list_path, int32_t format) {
+    struct fleet fleet;
+    struct timing time_data;
+    struct timespec start;
+    struct timespec end;
+    struct timespec diff;
+
+    fleet_init(&fleet);
+    timing_init(&time_data);
+
+    if (fleet_load_list(&fleet, list_path) != 0) {
+        return 1;
     }
 
-    for (int c = 0; c < args->iterations; c += 1) {
-        struct timespec start;
-        struct timespec end;
-        start.tv_sec = 0;
-        start.tv_nsec = 0;
-        end.tv_sec = 0;
-        end.tv_nsec = 0;
+    for (int32_t c = 0; c < args->iterations; c += 1) {
+        clock_gettime(CLOCK_MONOTONIC, &start);
 
-        if (clock_gettime(CLOCK_MONOTONIC, &start) != 0) {
-            fprintf(stderr, "failed to retrieve start time\n");
+        if (fleet_run(&fleet, args->algo, args->step, args->threads) != 0) {
+            fleet_free(&fleet);
 
-            continue;
+            return 1;
         }
 
-        double vel_final = 0.0;
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        timespec_diff(&start, &end, &diff);
+        timing_update(&time_data, &diff);
+    }
 
-        for (int32_t sec = 1; sec < lut->len; sec += 1) {
-            vel_final += sum_cb(
-                (double)(sec - 1),
-                (double)sec,
-                args->step,
-                (void*)lut,
-                calc_linear_interpolation
-            );
+    if (format == FORMAT_CSV) {
+        printf("train,path,velocity,position\n");
+    }
 
-            vel_lut.lut[sec] = vel_final;
+    for (int32_t train = 0; train < fleet.trains; train += 1) {
+        if (format == FORMAT_JSON) {
+            printf("{\"train\":%d,\"path\":", train);
+            batch_print_json_string(fleet.paths[train]);
+            printf(
+                ",\"velocity\":%.15lf,\"position\":%.15lf}\n",
+                fleet.velocity[train],
+                fleet.position[train]
+            );
+        } else {
+            printf("%d,", train);
+            batch_print_csv_string(fleet.paths[train]);
+            printf(",%.15lf,%.15lf\n", fleet.velocity[train], fleet.position[train]);
         }
+    }
 
-        double pos_final = 0.0;
+    printf(
+        "trains: %d entries: %d bytes: %lu isa: %s\n",
+        fleet.trains,
+        fleet.len,
+        (unsigned long)fleet_bytes(&fleet),
+        lut_kernel_isa_name(lut_kernel_isa())
+    );
+    timing_print(&time_data);
 
-        for (int32_t sec = 1; sec < vel_lut.len; sec += 1) {
-            pos_final += sum_cb(
-                (double)(sec - 1),
-                (double)sec,
-                args->step,
-                (void*)&vel_lut,
-                calc_linear_interpolation
-            );
+    fleet_free(&fleet);
+
+    return 0;
+}
+
+// simulates the profile once and writes its position index to the path
+int32_t sim_run_index_build(struct sim_args* args, struct lut_info* lut, const char* file_path) {
+    struct position_index index;
+    struct timespec start;
+    struct timespec end;
+    struct timespec diff;
+
+    position_index_init(&index);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    if (position_index_build(&index, args, lut) != 0) {
+        return 1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    timespec_diff(&start, &end, &diff);
+
+    int32_t rtn = position_index_write(&index, file_path);
+
+    if (rtn == 0) {
+        double vel;
+        double pos;
+
+        position_index_at(&index, (double)(index.len - 1), &vel, &pos);
+
+        printf("velocity: %.15lf\n", vel);
+        printf("position: %.15lf\n", pos);
+        printf(
+            "index: %d entries %d runs %lu bytes in %ld.%.9ld\n",
+            index.len,
+            index.run_count,
+            (unsigned long)position_index_bytes(&index),
+            diff.tv_sec,
+            diff.tv_nsec
+        );
+    }
+
+    position_index_free(&index);
+
+    return rtn;
+}
+
+static int32_t parse_index_time(const char* arg, const struct position_index* index, double* time) {
+    char* end = NULL;
+
+    errno = 0;
+    *time = strtod(arg, &end);
+
+    if (errno != 0 || end == arg || *end != '\0') {
+        return 1;
+    }
+
+    return index != NULL && !(*time >= 0.0 && *time <= (double)(index->len - 1));
+}
+
+// maps the index and answers the queries on stdin until it is closed
+int32_t sim_run_index_queries(const char* file_path) {
+    struct position_index index;
+
+    position_index_init(&index);
+
+    if (position_index_load(&index, file_path) != 0) {
+        return 1;
+    }
+
+    fprintf(
+        stderr,
+        "index: %d entries %d runs algo: %s step: %d\n",
+        index.len,
+        index.run_count,
+        get_lut_kernel(index.algo)->name,
+        index.step
+    );
+
+    char line[4096];
+
+    while (fgets(line, sizeof(line), stdin) != NULL) {
+        line[strcspn(line, "\r\n")] = '\0';
+
+        char* save = NULL;
+        char* command = strtok_r(line, " \t", &save);
+
+        if (command == NULL) {
+            continue;
         }
 
-        if (clock_gettime(CLOCK_MONOTONIC, &end) == 0) {
-            struct timespec diff;
+        if (strcmp(command, "at") == 0) {
+            // a line holds at most half as many times as it has characters
+            double times[sizeof(line) / 2];
+            int32_t count = 0;
+            int32_t valid = 1;
 
-            time_diff(&start, &end, &diff);
+            for (char* arg = strtok_r(NULL, " \t", &save); arg != NULL; arg = strtok_r(NULL, " \t", &save)) {
+                if (parse_index_time(arg, &index, &times[count]) != 0) {
+                    printf("err invalid time %s for %d entries\n", arg, index.len);
 
-            timing_update(&time_data, &diff);
+                    valid = 0;
 
-            switch (log_timer_update(&log_time)) {
-            case 1:
-                printf("iteration: %d\n", c);
+                    break;
+                }
 
-                timing_print(&time_data);
-                break;
-            case 0:
-                // all good
-                break;
-            case -1:
-                fprintf(stderr, "error when updating log_timer\n");
-                break;
+                count += 1;
             }
-        } else {
-            fprintf(stderr, "failed failed to retrieve end time. %s\n", strerror(errno));
 
-            break;
-        }
+            if (valid && count == 0) {
+                printf("err expected at least one <TIME>\n");
+            } else if (valid) {
+                fputs("ok", stdout);
+
+                for (int32_t c = 0; c < count; c += 1) {
+                    double vel;
+                    double pos;
+
+                    position_index_at(&index, times[c], &vel, &pos);
 
-        if (c == args->iterations - 1) {
-            printf("velocity: %.15lf\n", vel_final);
-            printf("position: %.15lf\n", pos_final);
+                    printf(" %.15lf %.15lf", vel, pos);
+                }
+
+                fputc('\n', stdout);
+            }
+        } else if (strcmp(command, "time") == 0) {
+            char* pos_arg = strtok_r(NULL, " \t", &save);
+            char* after_arg = strtok_r(NULL, " \t", &save);
+            double position;
+            double after = 0.0;
+            double time;
+
+            if (
+                pos_arg == NULL ||
+                parse_index_time(pos_arg, NULL, &position) != 0 ||
+                (after_arg != NULL && parse_index_time(after_arg, &index, &after) != 0)
+            ) {
+                printf("err expected <POS> [AFTER]\n");
+            } else if (position_index_time(&index, position, after, &time) != 0) {
+                printf("err position is not reached\n");
+            } else {
+                printf("ok %.9lf\n", time);
+            }
+        } else {
+            printf("err unknown command %s\n", command);
         }
+
+        fflush(stdout);
     }
 
-    timing_print(&time_data);
+    position_index_free(&index);
 
-    free(vel_lut.lut);
+    return 0;
 }
 
-void run_sim_openmp(struct sim_args* args, struct lut_info* lut) {
+// uploads the table to the offload device once and runs every iteration
+// there. the transfers are timed apart from the kernels to show how many
+// iterations it takes for the upload to pay off.
+int32_t sim_run_offload(struct sim_args* args, struct lut_info* lut) {
+    struct offload_sim sim;
     struct timing time_data;
-    struct log_timer log_time;
+    struct sim_result result;
+    struct timespec start;
+    struct timespec end;
+    struct timespec diff;
 
+    offload_sim_init(&sim);
     timing_init(&time_data);
-    log_timer_init(&log_time);
 
-    struct lut_info vel_lut;
-    vel_lut.len = lut->len;
-    vel_lut.lut = (double*)malloc(vel_lut.len * sizeof(double));
+    if (offload_sim_upload(&sim, args, lut) != 0) {
+        return 1;
+    }
+
+    for (int32_t c = 0; c < args->iterations; c += 1) {
+        clock_gettime(CLOCK_MONOTONIC, &start);
 
-    if (vel_lut.lut == NULL) {
-        fprintf(stderr, "failed allocating vel lookup table. %s\n", strerror(errno));
+        offload_sim_run(&sim, &result);
 
-        return;
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        timespec_diff(&start, &end, &diff);
+        timing_update(&time_data, &diff);
     }
 
-    vel_lut.lut[0] = 0.0;
+    printf("velocity: %.15lf\n", result.velocity);
+    printf("position: %.15lf\n", result.position);
+    printf("device: %d%s\n", sim.device, sim.host ? " (host fallback)" : "");
+    timing_print(&time_data);
+    offload_timing_print(&sim.timing);
+
+    offload_sim_free(&sim);
+
+    return 0;
+}
+
+static void print_error(const char* name, double value, double baseline) {
+    double diff = value - baseline;
+    double abs_diff = diff < 0.0 ? -diff : diff;
+    double abs_baseline = baseline < 0.0 ? -baseline : baseline;
+
+    printf(
+        "%s error: %.6e relative: %.6e\n",
+        name,
+        abs_diff,
+        abs_baseline > 0.0 ? abs_diff / abs_baseline : 0.0
+    );
+}
+
+// runs the fused pass over a single precision copy of the table and reports
+// how far it is from the double precision fused pass
+int32_t sim_run_precision(struct sim_args* args, struct lut_info* lut, int32_t precision) {
+    const struct lut_kernel_f* kernel_f = get_lut_kernel_f(args->algo);
 
-    summation sum_cb = left_riemann;
+    if (kernel_f == NULL) {
+        fprintf(stderr, "reduced precision is only available for the fixed step algorithms\n");
 
-    switch (args->algo) {
-    case LEFT_RIEMANN:
-        break;
-    case MID_RIEMANN:
-        sum_cb = mid_riemann;
-        break;
-    case RIGHT_RIEMANN:
-        sum_cb = right_riemann;
-        break;
-    case TRAPEZOIDAL:
-        sum_cb = trapezoidal;
-        break;
-    case SIMPSONS:
-        sum_cb = simpsons;
-        break;
+        return 1;
     }
 
-    for (int c = 0; c < args->iterations; c += 1) {
+    struct lut_info_f lut_f;
+
+    if (lut_info_f_init(&lut_f, lut) != 0) {
+        return 1;
+    }
+
+    lut_fused_f fused = precision == PRECISION_FLOAT
+        ? kernel_f->fused_float
+        : kernel_f->fused_mixed;
+    const struct lut_kernel* kernel = get_lut_kernel(args->algo);
+    struct timing reduced_time;
+    struct timing baseline_time;
+    struct fused_state reduced;
+    struct fused_state baseline;
+
+    timing_init(&reduced_time);
+    timing_init(&baseline_time);
+
+    for (int32_t c = 0; c < args->iterations; c += 1) {
         struct timespec start;
         struct timespec end;
-        start.tv_sec = 0;
-        start.tv_nsec = 0;
-        end.tv_sec = 0;
-        end.tv_nsec = 0;
+        struct timespec diff;
 
-        if (clock_gettime(CLOCK_MONOTONIC, &start) != 0) {
-            fprintf(stderr, "failed to retrieve start time\n");
+        reduced.vel = 0.0;
+        reduced.pos = 0.0;
 
-            continue;
-        }
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        fused(&lut_f, 1, lut_f.len, args->step, &reduced);
+        clock_gettime(CLOCK_MONOTONIC, &end);
 
-#pragma omp parallel for num_threads(args->threads)
-        for (int32_t sec = 1; sec < lut->len; sec += 1) {
-            vel_lut.lut[sec] = sum_cb(
-                (double)(sec - 1),
-                (double)sec,
-                args->step,
-                (void*)lut,
-                calc_linear_interpolation
-            );
-        }
+        timespec_diff(&start, &end, &diff);
+        timing_update(&reduced_time, &diff);
 
-        double vel_final = 0.0;
+        baseline.vel = 0.0;
+        baseline.pos = 0.0;
 
-        for (int32_t index = 0; index < vel_lut.len; index += 1) {
-            vel_final += vel_lut.lut[index];
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        kernel->fused(lut, 1, lut->len, args->step, &baseline);
+        clock_gettime(CLOCK_MONOTONIC, &end);
 
-            vel_lut.lut[index] = vel_final;
-        }
+        timespec_diff(&start, &end, &diff);
+        timing_update(&baseline_time, &diff);
+    }
 
-        double pos_final = 0.0;
+    printf("precision: %s\n", precision == PRECISION_FLOAT ? "float" : "mixed");
+    printf("velocity: %.15lf\n", reduced.vel);
+    printf("position: %.15lf\n", reduced.pos);
+    printf(
+        "table: %.3lf MB double: %.3lf MB\n",
+        (double)lut_f.len * sizeof(float) / (1024.0 * 1024.0),
+        (double)lut->len * sizeof(double) / (1024.0 * 1024.0)
+    );
+    timing_print(&reduced_time);
+
+    printf("baseline velocity: %.15lf\n", baseline.vel);
+    printf("baseline position: %.15lf\n", baseline.pos);
+    print_error("velocity", reduced.vel, baseline.vel);
+    print_error("position", reduced.pos, baseline.pos);
+    printf("baseline isa: %s\n", lut_kernel_isa_name(lut_kernel_isa()));
+    timing_print(&baseline_time);
+
+    lut_info_f_free(&lut_f);
 
-#pragma omp parallel for num_threads(args->threads) reduction(+:pos_final)
-        for (int32_t sec = 1; sec < vel_lut.len; sec += 1) {
-            pos_final += sum_cb(
-                (double)(sec - 1),
-                (double)sec,
-                args->step,
-                (void*)&vel_lut,
-                calc_linear_interpolation
-            );
-        }
+    return 0;
+}
 
-        if (clock_gettime(CLOCK_MONOTONIC, &end) == 0) {
-            struct timespec diff;
+static inline uint64_t check_random(uint64_t* state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
 
-            time_diff(&start, &end, &diff);
+    return *state;
+}
 
-            timing_update(&time_data, &diff);
+// the error of value relative to the baseline, or the absolute error when the
+// baseline is zero
+static double check_error(double value, double baseline) {
+    double diff = fabs(value - baseline);
 
-            switch (log_timer_update(&log_time)) {
-            case 1:
-                printf("iteration: %d\n", c);
+    return baseline != 0.0 ? diff / fabs(baseline) : diff;
+}
 
-                timing_print(&time_data);
-                break;
-            case 0:
-                // all good
-                break;
-            case -1:
-                fprintf(stderr, "error when updating log_timer\n");
-                break;
-            }
-        } else {
-            fprintf(stderr, "failed failed to retrieve end time. %s\n",strerror(errno));
+// applies the given number of random edits to the profile through
+// incremental_sim_update_range and after each one compares the incremental
+// result against a full simulation of the edited table. every edit replaces
+// a run of up to INCREMENTAL_CHECK_RUN entries, so the runs at either end of
+// the table are covered too. the edits come from a fixed seed so a failure
+// can be repeated. returns non zero if any result is further from the full
+// simulation than INCREMENTAL_CHECK_TOLERANCE.
+int32_t sim_run_incremental_check(struct sim_args* args, struct lut_info* lut, int32_t edits) {
+    struct lut_info table;
+    double values[INCREMENTAL_CHECK_RUN];
+
+    table.len = lut->len;
+    table.lut = (double*)malloc((size_t)lut->len * sizeof(double));
+
+    if (table.lut == NULL) {
+        fprintf(stderr, "failed allocating incremental check table. %s\n", strerror(errno));
+
+        return 1;
+    }
+
+    memcpy(table.lut, lut->lut, (size_t)lut->len * sizeof(double));
+
+    double scale = 0.0;
+
+    for (int32_t index = 0; index < lut->len; index += 1) {
+        scale = fmax(scale, fabs(lut->lut[index]));
+    }
+
+    if (scale == 0.0) {
+        scale = 1.0;
+    }
+
+    struct incremental_sim incremental;
+    struct sim_context context;
+
+    if (incremental_sim_init(&incremental, args, lut) != 0) {
+        free(table.lut);
+
+        return 1;
+    }
+
+    if (sim_context_init(&context, args, lut->len) != 0) {
+        sim_context_free(&context);
+        incremental_sim_free(&incremental);
+        free(table.lut);
+
+        return 1;
+    }
+
+    uint64_t state = 0x9e3779b97f4a7c15ull ^ (uint64_t)lut->len;
+    double vel_error = 0.0;
+    double pos_error = 0.0;
+    int32_t rtn = 0;
+
+    for (int32_t edit = 0; edit < edits && rtn == 0; edit += 1) {
+        int32_t first = (int32_t)(check_random(&state) % (uint64_t)lut->len);
+        int32_t room = lut->len - first < INCREMENTAL_CHECK_RUN ? lut->len - first : INCREMENTAL_CHECK_RUN;
+        int32_t count = 1 + (int32_t)(check_random(&state) % (uint64_t)room);
+
+        for (int32_t index = 0; index < count; index += 1) {
+            values[index] = scale * ((double)(check_random(&state) >> 11) / 9007199254740992.0 * 2.0 - 1.0);
+        }
+
+        memcpy(table.lut + first, values, (size_t)count * sizeof(double));
+
+        struct sim_result full;
+        struct sim_result result;
+
+        if (
+            incremental_sim_update_range(&incremental, first, values, count) != 0 ||
+            sim_context_run(&context, &table, &full) != 0
+        ) {
+            rtn = 1;
 
             break;
         }
 
-        if (c == args->iterations - 1) {
-            printf("velocity: %.15lf\n", vel_final);
-            printf("position: %.15lf\n", pos_final);
+        incremental_sim_result(&incremental, &result);
+
+        vel_error = fmax(vel_error, check_error(result.velocity, full.velocity));
+        pos_error = fmax(pos_error, check_error(result.position, full.position));
+
+        if (vel_error > INCREMENTAL_CHECK_TOLERANCE || pos_error > INCREMENTAL_CHECK_TOLERANCE) {
+            fprintf(
+                stderr,
+                "incremental result differs from the full simulation after edit %d. range: %d..%d "
+                "velocity: %.15lf full: %.15lf position: %.15lf full: %.15lf\n",
+                edit,
+                first,
+                first + count,
+                result.velocity,
+                full.velocity,
+                result.position,
+                full.position
+            );
+
+            rtn = 1;
         }
     }
 
-    timing_print(&time_data);
+    if (rtn == 0) {
+        printf("edits: %d\n", edits);
+        printf("velocity relative error: %.6e\n", vel_error);
+        printf("position relative error: %.6e\n", pos_error);
+    }
+
+    sim_context_free(&context);
+    incremental_sim_free(&incremental);
+    free(table.lut);
 
-    free(vel_lut.lut);
+    return rtn;
 }
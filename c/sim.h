@@ -6,10 +6,29 @@
 
 #include "summation.h"
 #include "args.h"
+#include "context.h"
 
-void run_sim(struct sim_args* args, struct lut_info* lut);
-void run_sim_openmp(struct sim_args* args, struct lut_info* lut);
+int32_t sim_run(struct sim_args* args, struct lut_info* lut, struct sim_result* result);
 
-int32_t load_data(const char* file_path);
+int32_t sim_run_serial(struct sim_args* args, struct lut_info* lut);
+int32_t sim_run_openmp(struct sim_args* args, struct lut_info* lut);
+int32_t sim_run_precision(struct sim_args* args, struct lut_info* lut, int32_t precision);
+int32_t sim_run_compressed(struct sim_args* args, struct lut_info* lut, double tolerance);
+int32_t sim_run_offload(struct sim_args* args, struct lut_info* lut);
+int32_t sim_run_fleet(struct sim_args* args, const char* list_path, int32_t format);
+int32_t sim_run_index_build(struct sim_args* args, struct lut_info* lut, const char* file_path);
+int32_t sim_run_index_queries(const char* file_path);
+int32_t sim_run_stream(struct sim_args* args, const char* file_path);
+int32_t sim_run_sweep(
+    struct sim_args* args,
+    struct lut_info* lut,
+    const int32_t* algos,
+    int32_t algos_len,
+    const int32_t* steps,
+    int32_t steps_len,
+    int32_t format
+);
+int32_t sim_run_trajectory(struct sim_args* args, struct lut_info* lut, const char* file_path, int32_t format);
+int32_t sim_run_incremental_check(struct sim_args* args, struct lut_info* lut, int32_t edits);
 
 #endif
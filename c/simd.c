@@ -0,0 +1,232 @@
+#include <stddef.h>
+#include <stdint.h>
+
+#include "args.h"
+#include "kernels.h"
+#include "precision.h"
+#include "simd.h"
+
+// vectorized segment summations. the sample points of every summation inside
+// of a segment are an arithmetic sequence t = idx * h + shift so each rule is
+// broken down into one or more weighted sums over evenly spaced indexs that
+// are evaluated several lanes at a time. the same generic code is compiled for
+// each instruction set using gcc vector extensions and target attributes.
+
+// sums y0 + t * slope for t = (first + i * stride) * h + shift, i in [0, count)
+#define DEFINE_SIMD_SUM_POINTS_T(name, seg_type, real, vec_t, width, attr)   \
+attr static inline real name(                                                \
+    seg_type seg,                                                            \
+    real h,                                                                  \
+    real shift,                                                              \
+    int32_t first,                                                           \
+    int32_t stride,                                                          \
+    int32_t count                                                            \
+) {                                                                          \
+    vec_t acc0 = {0};                                                        \
+    vec_t acc1 = {0};                                                        \
+    vec_t idx;                                                               \
+                                                                             \
+    for (int32_t lane = 0; lane < width; lane += 1) {                        \
+        idx[lane] = (real)(first + lane * stride);                           \
+    }                                                                        \
+                                                                             \
+    real inc = (real)(stride * width);                                       \
+    int32_t iter = 0;                                                        \
+                                                                             \
+    /* two accumulators to hide the latency of the adds */                   \
+    for (; iter + 2 * width <= count; iter += 2 * width) {                   \
+        vec_t t0 = idx * h + shift;                                          \
+        vec_t t1 = (idx + inc) * h + shift;                                  \
+                                                                             \
+        acc0 += seg->y0 + t0 * seg->slope;                                   \
+        acc1 += seg->y0 + t1 * seg->slope;                                   \
+        idx += (real)2.0 * inc;                                              \
+    }                                                                        \
+                                                                             \
+    acc0 += acc1;                                                            \
+                                                                             \
+    real sum = (real)0.0;                                                    \
+                                                                             \
+    for (int32_t lane = 0; lane < width; lane += 1) {                        \
+        sum += acc0[lane];                                                   \
+    }                                                                        \
+                                                                             \
+    for (; iter < count; iter += 1) {                                        \
+        real t = (real)(first + iter * stride) * h + shift;                  \
+                                                                             \
+        sum += seg->y0 + t * seg->slope;                                     \
+    }                                                                        \
+                                                                             \
+    return sum;                                                              \
+}
+
+// the five summation rules expressed with the sum_points primitive above
+#define DEFINE_SIMD_SUMMATIONS_T(prefix, seg_type, real, sum_points, interp, attr) \
+attr static inline real prefix##_left_riemann(                               \
+    seg_type seg, real lower, real upper, int32_t iterations                 \
+) {                                                                          \
+    real step = (upper - lower) / (real)iterations;                          \
+                                                                             \
+    return step * sum_points(seg, step, lower, 0, 1, iterations);            \
+}                                                                            \
+                                                                             \
+attr static inline real prefix##_mid_riemann(                                \
+    seg_type seg, real lower, real upper, int32_t iterations                 \
+) {                                                                          \
+    real step = (upper - lower) / (real)iterations;                          \
+                                                                             \
+    return step * sum_points(seg, step, lower + step / (real)2.0, 0, 1, iterations); \
+}                                                                            \
+                                                                             \
+attr static inline real prefix##_right_riemann(                              \
+    seg_type seg, real lower, real upper, int32_t iterations                 \
+) {                                                                          \
+    real step = (upper - lower) / (real)iterations;                          \
+                                                                             \
+    return step * sum_points(seg, step, lower, 1, 1, iterations);            \
+}                                                                            \
+                                                                             \
+attr static inline real prefix##_trapezoidal(                                \
+    seg_type seg, real lower, real upper, int32_t iterations                 \
+) {                                                                          \
+    real step = (upper - lower) / (real)iterations;                          \
+    real ends = (interp(seg, lower) + interp(seg, upper)) / (real)2.0;       \
+                                                                             \
+    return step * (ends + sum_points(seg, step, lower, 1, 1, iterations - 1)); \
+}                                                                            \
+                                                                             \
+attr static inline real prefix##_simpsons(                                   \
+    seg_type seg, real lower, real upper, int32_t iterations                 \
+) {                                                                          \
+    real step = (upper - lower) / (real)iterations;                          \
+    real ends = interp(seg, lower) +                                         \
+        interp(seg, lower + (real)iterations * step);                        \
+    real odd = sum_points(seg, step, lower, 1, 2, iterations / 2);           \
+    real even = sum_points(seg, step, lower, 2, 2, (iterations - 1) / 2);    \
+                                                                             \
+    return step * (ends + (real)4.0 * odd + (real)2.0 * even) / (real)3.0;   \
+}
+
+// the double precision versions used by the lut kernels
+#define DEFINE_SIMD_SUM_POINTS(name, vec_t, width, attr) \
+    DEFINE_SIMD_SUM_POINTS_T(name, const struct lut_segment*, double, vec_t, width, attr)
+
+#define DEFINE_SIMD_SUMMATIONS(prefix, sum_points, attr) \
+    DEFINE_SIMD_SUMMATIONS_T(prefix, const struct lut_segment*, double, sum_points, segment_interpolate, attr)
+
+// the single precision versions used by the precision kernels. each vector
+// holds twice as many lanes as the double precision one.
+#define DEFINE_SIMD_F_KERNELS(table, prefix, vec_t, width, attr)             \
+    DEFINE_SIMD_SUM_POINTS_T(prefix##_f_sum_points, const struct lut_segment_f*, float, vec_t, width, attr) \
+    DEFINE_SIMD_SUMMATIONS_T(prefix##_f, const struct lut_segment_f*, float, prefix##_f_sum_points, segment_f_interpolate, attr) \
+    DEFINE_LUT_KERNELS_F(table, prefix##_f, prefix, attr)
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#define AVX2_ATTR __attribute__((target("avx2,fma")))
+#define AVX512_ATTR __attribute__((target("avx512f,fma")))
+
+typedef double v4df __attribute__((vector_size(32)));
+typedef double v8df __attribute__((vector_size(64)));
+typedef float v8sf __attribute__((vector_size(32)));
+typedef float v16sf __attribute__((vector_size(64)));
+
+DEFINE_SIMD_SUM_POINTS(avx2_sum_points, v4df, 4, AVX2_ATTR)
+DEFINE_SIMD_SUMMATIONS(avx2, avx2_sum_points, AVX2_ATTR)
+DEFINE_LUT_KERNELS(AVX2_LUT_KERNELS, avx2, AVX2_ATTR)
+
+DEFINE_SIMD_SUM_POINTS(avx512_sum_points, v8df, 8, AVX512_ATTR)
+DEFINE_SIMD_SUMMATIONS(avx512, avx512_sum_points, AVX512_ATTR)
+DEFINE_LUT_KERNELS(AVX512_LUT_KERNELS, avx512, AVX512_ATTR)
+
+DEFINE_SIMD_F_KERNELS(AVX2_LUT_KERNELS_F, avx2, v8sf, 8, AVX2_ATTR)
+DEFINE_SIMD_F_KERNELS(AVX512_LUT_KERNELS_F, avx512, v16sf, 16, AVX512_ATTR)
+
+int32_t simd_supported(int32_t isa) {
+    __builtin_cpu_init();
+
+    switch (isa) {
+    case ISA_AVX2:
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    case ISA_AVX512:
+        return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("fma");
+    default:
+        return 0;
+    }
+}
+
+const struct lut_kernel* get_simd_kernels(int32_t isa) {
+    if (!simd_supported(isa)) {
+        return NULL;
+    }
+
+    switch (isa) {
+    case ISA_AVX2:
+        return AVX2_LUT_KERNELS;
+    case ISA_AVX512:
+        return AVX512_LUT_KERNELS;
+    default:
+        return NULL;
+    }
+}
+
+const struct lut_kernel_f* get_simd_kernels_f(int32_t isa) {
+    if (!simd_supported(isa)) {
+        return NULL;
+    }
+
+    switch (isa) {
+    case ISA_AVX2:
+        return AVX2_LUT_KERNELS_F;
+    case ISA_AVX512:
+        return AVX512_LUT_KERNELS_F;
+    default:
+        return NULL;
+    }
+}
+
+#elif defined(__aarch64__)
+
+// advanced simd is always available on aarch64 so there is nothing to detect
+typedef double v2df __attribute__((vector_size(16)));
+typedef float v4sf __attribute__((vector_size(16)));
+
+DEFINE_SIMD_SUM_POINTS(neon_sum_points, v2df, 2, )
+DEFINE_SIMD_SUMMATIONS(neon, neon_sum_points, )
+DEFINE_LUT_KERNELS(NEON_LUT_KERNELS, neon, )
+
+DEFINE_SIMD_F_KERNELS(NEON_LUT_KERNELS_F, neon, v4sf, 4, )
+
+int32_t simd_supported(int32_t isa) {
+    return isa == ISA_NEON;
+}
+
+const struct lut_kernel* get_simd_kernels(int32_t isa) {
+    return isa == ISA_NEON ? NEON_LUT_KERNELS : NULL;
+}
+
+const struct lut_kernel_f* get_simd_kernels_f(int32_t isa) {
+    return isa == ISA_NEON ? NEON_LUT_KERNELS_F : NULL;
+}
+
+#else
+
+int32_t simd_supported(int32_t isa) {
+    (void)isa;
+
+    return 0;
+}
+
+const struct lut_kernel* get_simd_kernels(int32_t isa) {
+    (void)isa;
+
+    return NULL;
+}
+
+const struct lut_kernel_f* get_simd_kernels_f(int32_t isa) {
+    (void)isa;
+
+    return NULL;
+}
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <stdint.h>
+
+#include "kernels.h"
+#include "precision.h"
+
+int32_t simd_supported(int32_t isa);
+const struct lut_kernel* get_simd_kernels(int32_t isa);
+const struct lut_kernel_f* get_simd_kernels_f(int32_t isa);
+
+#endif
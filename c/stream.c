@@ -0,0 +1,306 @@
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "csv.h"
+#include "stream.h"
+#include "ts.h"
+
+static inline void stream_pause() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+// wakes the other side if it went to sleep. the flag is read after the head
+// or tail was published so either the sleeping side sees the new value or
+// this side sees the flag
+static void stream_wake(struct stream_reader* self, _Atomic int32_t* waiting) {
+    if (atomic_load(waiting)) {
+        pthread_mutex_lock(&self->lock);
+        pthread_cond_broadcast(&self->cond);
+        pthread_mutex_unlock(&self->lock);
+    }
+}
+
+static inline int32_t stream_ring_full(struct stream_reader* self, uint64_t tail) {
+    return tail - atomic_load(&self->head) == STREAM_RING_LEN;
+}
+
+// non zero while the simulation has nothing to take from the ring and the
+// reader thread has not finished
+static inline int32_t stream_ring_empty(struct stream_reader* self, uint64_t head) {
+    return head == atomic_load(&self->tail) && !atomic_load(&self->done);
+}
+
+// parses entries into the chunk after offset until it is full or the file
+// ends. added is the number of entries parsed into it
+static int32_t stream_fill_chunk(struct stream_reader* self, struct stream_chunk* chunk, size_t offset, size_t* added) {
+    *added = 0;
+
+    while (offset + *added < self->chunk_len) {
+        size_t count = 0;
+
+        if (csv_reader_next(&self->reader, chunk->values + offset + *added, self->chunk_len - offset - *added, &count) != 0) {
+            return 1;
+        }
+
+        if (count == 0) {
+            break;
+        }
+
+        *added += count;
+    }
+
+    return 0;
+}
+
+static void* stream_reader_thread(void* data) {
+    struct stream_reader* self = (struct stream_reader*)data;
+    double carry = 0.0;
+    int32_t has_carry = 0;
+
+    while (1) {
+        uint64_t tail = atomic_load_explicit(&self->tail, memory_order_relaxed);
+
+        if (stream_ring_full(self, tail)) {
+            struct timespec start;
+            struct timespec end;
+            struct timespec diff;
+
+            clock_gettime(CLOCK_MONOTONIC, &start);
+
+            for (int32_t spin = 0; spin < STREAM_SPIN && stream_ring_full(self, tail); spin += 1) {
+                stream_pause();
+            }
+
+            if (stream_ring_full(self, tail)) {
+                pthread_mutex_lock(&self->lock);
+                atomic_store(&self->reader_waiting, 1);
+
+                while (stream_ring_full(self, tail)) {
+                    pthread_cond_wait(&self->cond, &self->lock);
+                }
+
+                atomic_store(&self->reader_waiting, 0);
+                pthread_mutex_unlock(&self->lock);
+            }
+
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            timespec_diff(&start, &end, &diff);
+            timespec_add(&self->stall_time, &diff, &self->stall_time);
+        }
+
+        struct stream_chunk* chunk = &self->chunks[tail % STREAM_RING_LEN];
+        size_t offset = 0;
+        size_t added = 0;
+
+        if (has_carry) {
+            chunk->values[0] = carry;
+            offset = 1;
+        }
+
+        struct timespec start;
+        struct timespec end;
+        struct timespec diff;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+
+        int32_t failed = stream_fill_chunk(self, chunk, offset, &added);
+
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        timespec_diff(&start, &end, &diff);
+        timespec_add(&self->read_time, &diff, &self->read_time);
+
+        if (failed) {
+            self->failed = 1;
+
+            break;
+        }
+
+        if (added == 0) {
+            break;
+        }
+
+        chunk->len = (int32_t)(offset + added);
+        carry = chunk->values[chunk->len - 1];
+        has_carry = 1;
+
+        self->entries += added;
+
+        atomic_store(&self->tail, tail + 1);
+        stream_wake(self, &self->sim_waiting);
+
+        if (offset + added < self->chunk_len) {
+            break;
+        }
+    }
+
+    self->bytes = self->reader.bytes;
+
+    atomic_store(&self->done, 1);
+    stream_wake(self, &self->sim_waiting);
+
+    return NULL;
+}
+
+int32_t stream_reader_open(struct stream_reader* self, const char* file_path, size_t chunk_len) {
+    memset(self->chunks, 0, sizeof(self->chunks));
+    self->chunk_len = chunk_len;
+    atomic_init(&self->head, 0);
+    atomic_init(&self->tail, 0);
+    atomic_init(&self->done, 0);
+    atomic_init(&self->reader_waiting, 0);
+    atomic_init(&self->sim_waiting, 0);
+    self->failed = 0;
+    self->started = 0;
+    self->entries = 0;
+    self->bytes = 0;
+    self->read_time.tv_sec = 0;
+    self->read_time.tv_nsec = 0;
+    self->stall_time.tv_sec = 0;
+    self->stall_time.tv_nsec = 0;
+    self->wait_time.tv_sec = 0;
+    self->wait_time.tv_nsec = 0;
+
+    if (chunk_len < 2 || chunk_len > INT32_MAX) {
+        fprintf(stderr, "invalid stream chunk length. %lu\n", (unsigned long)chunk_len);
+
+        return 1;
+    }
+
+    if (csv_reader_open(&self->reader, file_path, CSV_BUFFER_SIZE) != 0) {
+        return 1;
+    }
+
+    for (int32_t index = 0; index < STREAM_RING_LEN; index += 1) {
+        self->chunks[index].values = (double*)malloc(chunk_len * sizeof(double));
+
+        if (self->chunks[index].values == NULL) {
+            fprintf(stderr, "failed allocating stream chunks. %s\n", strerror(errno));
+
+            stream_reader_close(self);
+
+            return 1;
+        }
+    }
+
+    pthread_mutex_init(&self->lock, NULL);
+    pthread_cond_init(&self->cond, NULL);
+
+    int rtn = pthread_create(&self->thread, NULL, stream_reader_thread, self);
+
+    if (rtn != 0) {
+        fprintf(stderr, "failed to start stream reader thread. %s\n", strerror(rtn));
+
+        pthread_cond_destroy(&self->cond);
+        pthread_mutex_destroy(&self->lock);
+        stream_reader_close(self);
+
+        return 1;
+    }
+
+    self->started = 1;
+
+    return 0;
+}
+
+// waits for the reader thread to finish and releases the chunks. the reader
+// thread always runs to the end of the file so the chunks left in the ring
+// are drained first. returns non zero if the file failed to be read
+int32_t stream_reader_close(struct stream_reader* self) {
+    if (self->started) {
+        while (stream_reader_next(self) != NULL) {
+            stream_reader_release(self);
+        }
+
+        pthread_join(self->thread, NULL);
+
+        pthread_cond_destroy(&self->cond);
+        pthread_mutex_destroy(&self->lock);
+
+        self->started = 0;
+    }
+
+    csv_reader_close(&self->reader);
+
+    for (int32_t index = 0; index < STREAM_RING_LEN; index += 1) {
+        free(self->chunks[index].values);
+
+        self->chunks[index].values = NULL;
+    }
+
+    return self->failed;
+}
+
+void stream_reader_print(struct stream_reader* self) {
+    printf(
+        "stream: %lu entries %.3lf MB read: %ld.%.9ld stall: %ld.%.9ld wait: %ld.%.9ld\n",
+        (unsigned long)self->entries,
+        (double)self->bytes / (1024.0 * 1024.0),
+        self->read_time.tv_sec,
+        self->read_time.tv_nsec,
+        self->stall_time.tv_sec,
+        self->stall_time.tv_nsec,
+        self->wait_time.tv_sec,
+        self->wait_time.tv_nsec
+    );
+}
+
+// returns the oldest filled chunk, waiting for the reader thread if none are
+// ready. returns NULL once every chunk of the file has been consumed. the
+// chunk belongs to the caller until it is released
+const struct stream_chunk* stream_reader_next(struct stream_reader* self) {
+    uint64_t head = atomic_load_explicit(&self->head, memory_order_relaxed);
+
+    if (head != atomic_load(&self->tail)) {
+        return &self->chunks[head % STREAM_RING_LEN];
+    }
+
+    struct timespec start;
+    struct timespec end;
+    struct timespec diff;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (int32_t spin = 0; spin < STREAM_SPIN && stream_ring_empty(self, head); spin += 1) {
+        stream_pause();
+    }
+
+    if (stream_ring_empty(self, head)) {
+        pthread_mutex_lock(&self->lock);
+        atomic_store(&self->sim_waiting, 1);
+
+        while (stream_ring_empty(self, head)) {
+            pthread_cond_wait(&self->cond, &self->lock);
+        }
+
+        atomic_store(&self->sim_waiting, 0);
+        pthread_mutex_unlock(&self->lock);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    timespec_diff(&start, &end, &diff);
+    timespec_add(&self->wait_time, &diff, &self->wait_time);
+
+    // done is only set after the last chunk has been published so an empty
+    // ring at this point means every chunk has been consumed
+    if (head == atomic_load(&self->tail)) {
+        return NULL;
+    }
+
+    return &self->chunks[head % STREAM_RING_LEN];
+}
+
+// hands the chunk returned by stream_reader_next back to the reader thread
+void stream_reader_release(struct stream_reader* self) {
+    uint64_t head = atomic_load_explicit(&self->head, memory_order_relaxed);
+
+    atomic_store(&self->head, head + 1);
+    stream_wake(self, &self->reader_waiting);
+}
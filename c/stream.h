@@ -0,0 +1,76 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "csv.h"
+
+// the default number of entries parsed into each chunk
+#define STREAM_CHUNK_LEN (1 << 16)
+// the chunks the reader thread is able to parse ahead of the simulation
+#define STREAM_RING_LEN 8
+// the times a side checks the ring again before it blocks until the other
+// side wakes it
+#define STREAM_SPIN 4096
+
+// a run of entries parsed from the file. every chunk after the first starts
+// with the last entry of the chunk before it so each one is a table of its
+// own and the boundary state carries over from one to the next unchanged.
+struct stream_chunk {
+    double* values;
+    int32_t len;
+};
+
+// parses a csv profile from a dedicated thread into a single producer single
+// consumer ring of chunks so the simulation is integrating the chunks that
+// have been read while the rest of the file is still being read. the reader
+// thread only ever writes tail and the simulation only ever writes head so
+// neither side takes a lock while the ring has room and chunks ready. a side
+// that finds the ring full or empty spins for a short while and then sleeps
+// on the condition until the other side wakes it, so a waiting side does not
+// take a cpu away from the simulation threads.
+struct stream_reader {
+    struct csv_reader reader;
+
+    struct stream_chunk chunks[STREAM_RING_LEN];
+    size_t chunk_len;
+
+    // chunks [head, tail) are filled and waiting on the simulation
+    _Atomic uint64_t head;
+    _Atomic uint64_t tail;
+    // set by the reader thread after its last chunk has been published
+    _Atomic int32_t done;
+    int32_t failed;
+
+    // only taken by a side that is about to sleep and by the side waking it.
+    // the waiting flags are set before the ring is checked one last time so
+    // a wake up is never missed
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    _Atomic int32_t reader_waiting;
+    _Atomic int32_t sim_waiting;
+
+    pthread_t thread;
+    int32_t started;
+
+    uint64_t entries;
+    uint64_t bytes;
+    // time the reader thread spent parsing, the time it waited on a full ring
+    // and the time the simulation waited on an empty ring
+    struct timespec read_time;
+    struct timespec stall_time;
+    struct timespec wait_time;
+};
+
+int32_t stream_reader_open(struct stream_reader* self, const char* file_path, size_t chunk_len);
+int32_t stream_reader_close(struct stream_reader* self);
+void stream_reader_print(struct stream_reader* self);
+
+const struct stream_chunk* stream_reader_next(struct stream_reader* self);
+void stream_reader_release(struct stream_reader* self);
+
+#endif
@@ -5,7 +5,7 @@
 
 #include "summation.h"
 
-double get_lut_index(struct lut_info* lut, int32_t index) {
+double lut_get_index(struct lut_info* lut, int32_t index) {
     // if the given lut does not cover the range because it is only a small
     // subset of the total then we can use the offset to get the appropriate
     // index with the specified offset
@@ -25,13 +25,13 @@ double get_lut_index(struct lut_info* lut, int32_t index) {
 
 // linear interpolation using this equation:
 // y = y0 + ((x - x0) * ((y1 - y0) / (x1 - x0)))
-double calc_linear_interpolation(void* context, double x) {
+double lut_linear_interpolation(void* context, double x) {
     struct lut_info* lut = (struct lut_info*)context;
 
     if (floor(x) == x) {
         // the x value we are given will just be an index which we know so just
         // go get it
-        return get_lut_index(lut, (int32_t)x);
+        return lut_get_index(lut, (int32_t)x);
     }
 
     // cast the given doule to an int which will truncate all decimals and give
@@ -43,8 +43,8 @@ double calc_linear_interpolation(void* context, double x) {
     double x0 = (double)x0_index;
     // since x1 will always be 1 greater than x0
     //double x1 = (double)x1_index;
-    double y0 = get_lut_index(lut, x0_index);
-    double y1 = get_lut_index(lut, x1_index);
+    double y0 = lut_get_index(lut, x0_index);
+    double y1 = lut_get_index(lut, x1_index);
 
     // if x1 is always 1 greather than x0 then it can be removed and just 1;
     //return y0 + (x - x0) * ((y1 - y0) / (x1 - x0));
@@ -53,7 +53,7 @@ double calc_linear_interpolation(void* context, double x) {
 
 // summation functions
 
-double left_riemann(
+double summation_left_riemann(
     double lower,
     double upper,
     int32_t iterations,
@@ -73,7 +73,7 @@ double left_riemann(
     return step * sum;
 }
 
-double mid_riemann(
+double summation_mid_riemann(
     double lower,
     double upper,
     int32_t iterations,
@@ -94,7 +94,7 @@ double mid_riemann(
     return step * sum;
 }
 
-double right_riemann(
+double summation_right_riemann(
     double lower,
     double upper,
     int32_t iterations,
@@ -113,7 +113,7 @@ double right_riemann(
     return step * sum;
 }
 
-double trapezoidal(
+double summation_trapezoidal(
     double lower,
     double upper,
     int32_t iterations,
@@ -132,7 +132,7 @@ double trapezoidal(
     return step * sum;
 }
 
-double simpsons(
+double summation_simpsons(
     double lower,
     double upper,
     int32_t iterations,
@@ -157,3 +157,82 @@ double simpsons(
 
     return step * sum / 3.0;
 }
+
+// the number of times the step is halved for romberg to reach steps as narrow
+// as a fixed summation with the given number of steps
+int32_t summation_romberg_levels(int32_t iterations) {
+    int32_t levels = 0;
+
+    while (levels < ROMBERG_MAX_LEVELS && ((int64_t)1 << levels) < iterations) {
+        levels += 1;
+    }
+
+    return levels;
+}
+
+// romberg integration on top of the trapezoidal rule. every level halves the
+// step of the previous trapezoidal estimate, which only needs the new
+// midpoints since T(h / 2) = T(h) / 2 + h / 2 * sum(f(midpoints)), and then
+// richardson extrapolation removes the leading error terms. refining stops
+// once two successive diagonal estimates are within tolerance or the step is
+// as narrow as iterations steps.
+double summation_romberg_tolerance(
+    double lower,
+    double upper,
+    int32_t iterations,
+    double tolerance,
+    void* context,
+    summation_cb cb
+) {
+    int32_t levels = summation_romberg_levels(iterations);
+    double rows[2][ROMBERG_MAX_LEVELS + 1];
+    double* prev = rows[0];
+    double* curr = rows[1];
+    double step = upper - lower;
+
+    prev[0] = step * (cb(context, lower) + cb(context, upper)) / 2.0;
+
+    for (int32_t level = 1; level <= levels; level += 1) {
+        int32_t count = 1 << (level - 1);
+        double sum = 0.0;
+
+        step /= 2.0;
+
+        for (int32_t iter = 0; iter < count; iter += 1) {
+            sum += cb(context, lower + (double)(2 * iter + 1) * step);
+        }
+
+        curr[0] = prev[0] / 2.0 + step * sum;
+
+        double factor = 4.0;
+
+        for (int32_t col = 1; col <= level; col += 1) {
+            curr[col] = curr[col - 1] + (curr[col - 1] - prev[col - 1]) / (factor - 1.0);
+            factor *= 4.0;
+        }
+
+        double delta = curr[level] - prev[level - 1];
+
+        if ((delta < 0.0 ? -delta : delta) <= tolerance) {
+            return curr[level];
+        }
+
+        double* swap = prev;
+        prev = curr;
+        curr = swap;
+    }
+
+    return prev[levels];
+}
+
+// romberg with ROMBERG_DEFAULT_TOLERANCE so it has the same signature as the
+// other summation functions
+double summation_romberg(
+    double lower,
+    double upper,
+    int32_t iterations,
+    void* context,
+    summation_cb cb
+) {
+    return summation_romberg_tolerance(lower, upper, iterations, ROMBERG_DEFAULT_TOLERANCE, context, cb);
+}
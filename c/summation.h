@@ -8,15 +8,30 @@ struct lut_info {
     double* lut;
 };
 
+// the most times romberg will halve the step of an interval
+#define ROMBERG_MAX_LEVELS 20
+
+// the absolute difference between two successive romberg estimates at which
+// the estimate is accepted when no tolerance is given
+#define ROMBERG_DEFAULT_TOLERANCE 1e-9
+
 typedef double (*summation_cb)(void*, double);
 typedef double (*summation)(double, double, int32_t, void*, summation_cb);
 
-double get_lut_index(struct lut_info* lut, int32_t index);
-double calc_linear_interpolation(void* context, double x);
+double lut_get_index(struct lut_info* lut, int32_t index);
+double lut_linear_interpolation(void* context, double x);
 
 // summation functions
 
-double left_riemann(
+double summation_left_riemann(
+    double lower,
+    double upper,
+    int32_t iterations,
+    void* context,
+    summation_cb cb
+);
+
+double summation_mid_riemann(
     double lower,
     double upper,
     int32_t iterations,
@@ -24,7 +39,7 @@ double left_riemann(
     summation_cb cb
 );
 
-double mid_riemann(
+double summation_right_riemann(
     double lower,
     double upper,
     int32_t iterations,
@@ -32,7 +47,7 @@ double mid_riemann(
     summation_cb cb
 );
 
-double right_riemann(
+double summation_trapezoidal(
     double lower,
     double upper,
     int32_t iterations,
@@ -40,15 +55,26 @@ double right_riemann(
     summation_cb cb
 );
 
-double trapezoidal(
+double summation_simpsons(
+    double lower,
+    double upper,
+    int32_t iterations,
+    void* context,
+    summation_cb cb
+);
+
+int32_t summation_romberg_levels(int32_t iterations);
+
+double summation_romberg_tolerance(
     double lower,
     double upper,
     int32_t iterations,
+    double tolerance,
     void* context,
     summation_cb cb
 );
 
-double simpsons(
+double summation_romberg(
     double lower,
     double upper,
     int32_t iterations,
@@ -0,0 +1,188 @@
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+
+#include "args.h"
+#include "kernels.h"
+#include "parallel.h"
+#include "sweep.h"
+
+void sweep_init(struct sweep* self) {
+    self->points = NULL;
+    self->len = 0;
+    self->i0 = NULL;
+    self->i1 = NULL;
+    self->q0 = NULL;
+    self->j0 = NULL;
+    self->j1 = NULL;
+}
+
+void sweep_free(struct sweep* self) {
+    free(self->points);
+    free(self->i0);
+
+    sweep_init(self);
+}
+
+// spreads the coefficients of a point over the arrays the lanes are read from
+static void sweep_coefficients(struct sweep* self, int32_t point) {
+    struct lut_interval_coeffs coeffs;
+
+    lut_interval_coeffs(get_lut_kernel(self->points[point].algo), self->points[point].step, &coeffs);
+
+    self->i0[point] = coeffs.i0;
+    self->i1[point] = coeffs.i1;
+    self->q0[point] = coeffs.q0;
+    self->j0[point] = coeffs.j0;
+    self->j1[point] = coeffs.j1;
+}
+
+// builds every combination of the given algos and steps followed by the exact
+// reference point. the exact kernel does not depend on the step so it only
+// shows up once for each step in the results.
+int32_t sweep_build(
+    struct sweep* self,
+    const int32_t* algos,
+    int32_t algos_len,
+    const int32_t* steps,
+    int32_t steps_len
+) {
+    sweep_free(self);
+
+    int32_t len = algos_len * steps_len + 1;
+
+    self->points = (struct sweep_point*)malloc((size_t)len * sizeof(struct sweep_point));
+    self->i0 = (double*)malloc((size_t)len * 5 * sizeof(double));
+
+    if (self->points == NULL || self->i0 == NULL) {
+        fprintf(stderr, "failed allocating sweep points. %s\n", strerror(errno));
+
+        sweep_free(self);
+
+        return 1;
+    }
+
+    self->len = len;
+    self->i1 = self->i0 + len;
+    self->q0 = self->i1 + len;
+    self->j0 = self->q0 + len;
+    self->j1 = self->j0 + len;
+
+    int32_t point = 0;
+
+    for (int32_t algo = 0; algo < algos_len; algo += 1) {
+        for (int32_t step = 0; step < steps_len; step += 1) {
+            self->points[point].algo = algos[algo];
+            self->points[point].step = steps[step];
+            point += 1;
+        }
+    }
+
+    self->points[point].algo = EXACT;
+    self->points[point].step = 1;
+
+    for (point = 0; point < len; point += 1) {
+        self->points[point].velocity = 0.0;
+        self->points[point].position = 0.0;
+
+        sweep_coefficients(self, point);
+    }
+
+    return 0;
+}
+
+// advances the state of every point over [first, last) of the table
+static void sweep_block(
+    const struct sweep* self,
+    const struct lut_info* lut,
+    int32_t first,
+    int32_t last,
+    double* vel,
+    double* pos
+) {
+    int32_t len = self->len;
+    const double* i0 = self->i0;
+    const double* i1 = self->i1;
+    const double* q0 = self->q0;
+    const double* j0 = self->j0;
+    const double* j1 = self->j1;
+
+    for (int32_t sec = first; sec < last; sec += 1) {
+        double a0 = lut->lut[sec - 1];
+        double slope = lut->lut[sec] - a0;
+
+        for (int32_t point = 0; point < len; point += 1) {
+            pos[point] += q0[point] * vel[point] + j0[point] * a0 + j1[point] * slope;
+            vel[point] += i0[point] * a0 + i1[point] * slope;
+        }
+    }
+}
+
+// runs every point of the sweep over the table in a single pass. with more
+// than one thread each thread runs its own block of the table from zero and
+// the blocks are joined in order the same as the fused runners, where
+// starting a block at velocity v adds v * q0 to the position of each of its
+// intervals.
+int32_t sweep_run(struct sweep* self, struct lut_info* lut, int32_t threads) {
+    int32_t len = self->len;
+    double* state = (double*)calloc((size_t)threads * 2 * (size_t)len, sizeof(double));
+
+    if (state == NULL) {
+        fprintf(stderr, "failed allocating sweep state. %s\n", strerror(errno));
+
+        return 1;
+    }
+
+    int32_t* intervals = (int32_t*)calloc((size_t)threads, sizeof(int32_t));
+
+    if (intervals == NULL) {
+        fprintf(stderr, "failed allocating sweep state. %s\n", strerror(errno));
+
+        free(state);
+
+        return 1;
+    }
+
+    int32_t used = 1;
+
+#pragma omp parallel num_threads(threads)
+    {
+        int32_t thread = omp_get_thread_num();
+        double* vel = state + (size_t)thread * 2 * (size_t)len;
+        double* pos = vel + len;
+        int32_t first;
+        int32_t last;
+
+        parallel_thread_range(1, lut->len, &first, &last);
+
+        intervals[thread] = last - first;
+
+        sweep_block(self, lut, first, last, vel, pos);
+
+#pragma omp single
+        used = omp_get_num_threads();
+    }
+
+    for (int32_t point = 0; point < len; point += 1) {
+        double vel = 0.0;
+        double pos = 0.0;
+
+        for (int32_t thread = 0; thread < used; thread += 1) {
+            const double* block = state + (size_t)thread * 2 * (size_t)len;
+
+            pos += block[len + point] + vel * self->q0[point] * (double)intervals[thread];
+            vel += block[point];
+        }
+
+        self->points[point].velocity = vel;
+        self->points[point].position = pos;
+    }
+
+    free(intervals);
+    free(state);
+
+    return 0;
+}
@@ -0,0 +1,47 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <stdint.h>
+
+#include "summation.h"
+
+// the exact kernel is always simulated next to the requested combinations as
+// the reference their errors are measured against
+struct sweep_point {
+    int32_t algo;
+    int32_t step;
+    double velocity;
+    double position;
+};
+
+// every (algo, step) combination of a parameter sweep. the acceleration is
+// linear inside of each interval so every summation rule reduces to a handful
+// of coefficients that only depend on the algo and step. they are evaluated
+// once per combination and the table is then read a single time for all of
+// them.
+struct sweep {
+    struct sweep_point* points;
+    int32_t len;
+
+    // structure of arrays of the coefficients of each point so the inner
+    // loop over the points vectorizes
+    double* i0;
+    double* i1;
+    double* q0;
+    double* j0;
+    double* j1;
+};
+
+void sweep_init(struct sweep* self);
+void sweep_free(struct sweep* self);
+
+int32_t sweep_build(
+    struct sweep* self,
+    const int32_t* algos,
+    int32_t algos_len,
+    const int32_t* steps,
+    int32_t steps_len
+);
+int32_t sweep_run(struct sweep* self, struct lut_info* lut, int32_t threads);
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef TRAINSIM_H
+#define TRAINSIM_H
+
+// single header for embedding the simulator through libtrainsim.a or
+// libtrainsim.so. the typical flow is:
+//
+//   struct profile profile;
+//   profile_load("accel.bin", &profile);
+//
+//   struct sim_args args;
+//   sim_args_init(&args);
+//
+//   struct sim_context context;
+//   sim_context_init(&context, &args, profile.lut.len);
+//
+//   struct sim_result result;
+//   sim_context_run(&context, &profile.lut, &result);
+//
+//   sim_context_free(&context);
+//   profile_free(&profile);
+//
+// when only part of the profile changes between runs an incremental_sim can
+// be updated with incremental_sim_update_range() instead of running the whole
+// simulation again.
+//
+// every function that can fail returns 0 on success. the major version is
+// only changed when the layout of a struct or the signature of a function in
+// these headers changes. always start from sim_args_init() so the fields
+// added to sim_args by a later version keep their defaults.
+//
+// 2.0 added sim_args_init() and the reduction, schedule, chunk, bind,
+// persistent, profile, cycles, profile_path, profile_format and perf fields
+// of sim_args. every exported function now carries the prefix of its module.
+// -a adaptive-simpsons and -a romberg are gone from the table kernels along
+// with lut_kernel_set_tolerance() since every interval of the table is linear
+// and neither ever refined past its first estimate.
+// sim_run_serial() and sim_run_openmp() return whether they succeeded.
+
+#define TRAINSIM_VERSION_MAJOR 2
+#define TRAINSIM_VERSION_MINOR 0
+
+#include "args.h"
+#include "context.h"
+#include "fleet.h"
+#include "incremental.h"
+#include "kernels.h"
+#include "position_index.h"
+#include "precision.h"
+#include "profile.h"
+#include "segments.h"
+#include "server.h"
+#include "stream.h"
+#include "sim.h"
+#include "summation.h"
+#include "sweep.h"
+
+#endif
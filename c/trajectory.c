@@ -0,0 +1,363 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "args.h"
+#include "trajectory.h"
+#include "ts.h"
+
+// the longest line a single csv sample can produce. each double is at most
+// 24 characters with %.17g
+#define TRAJECTORY_CSV_LINE 128
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define TRAJECTORY_SWAP_BYTES 1
+#else
+#define TRAJECTORY_SWAP_BYTES 0
+#endif
+
+static uint32_t swap_u32(uint32_t value) {
+#if TRAJECTORY_SWAP_BYTES
+    return __builtin_bswap32(value);
+#else
+    return value;
+#endif
+}
+
+static int32_t write_all(int fd, const void* data, size_t len) {
+    const char* iter = (const char*)data;
+
+    while (len > 0) {
+        ssize_t amount = write(fd, iter, len);
+
+        if (amount < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            fprintf(stderr, "failed writing trajectory. %s\n", strerror(errno));
+
+            return 1;
+        }
+
+        iter += amount;
+        len -= (size_t)amount;
+    }
+
+    return 0;
+}
+
+static int32_t write_samples(struct trajectory_writer* self, struct trajectory_sample* samples, size_t len) {
+    if (self->format == TRAJECTORY_BINARY) {
+#if TRAJECTORY_SWAP_BYTES
+        // the buffer is not touched by the simulation until it is handed back
+        // so it can be swapped in place
+        uint64_t* words = (uint64_t*)samples;
+
+        for (size_t index = 0; index < len * 4; index += 1) {
+            words[index] = __builtin_bswap64(words[index]);
+        }
+#endif
+        self->bytes += len * sizeof(struct trajectory_sample);
+
+        return write_all(self->fd, samples, len * sizeof(struct trajectory_sample));
+    }
+
+    size_t used = 0;
+
+    for (size_t index = 0; index < len; index += 1) {
+        if (self->text_capacity - used < TRAJECTORY_CSV_LINE) {
+            if (write_all(self->fd, self->text, used) != 0) {
+                return 1;
+            }
+
+            self->bytes += used;
+            used = 0;
+        }
+
+        used += (size_t)snprintf(
+            self->text + used,
+            self->text_capacity - used,
+            "%.17g,%.17g,%.17g,%.17g\n",
+            samples[index].time,
+            samples[index].accel,
+            samples[index].vel,
+            samples[index].pos
+        );
+    }
+
+    self->bytes += used;
+
+    return write_all(self->fd, self->text, used);
+}
+
+static void* trajectory_writer_thread(void* data) {
+    struct trajectory_writer* self = (struct trajectory_writer*)data;
+
+    pthread_mutex_lock(&self->lock);
+
+    while (1) {
+        while (!self->pending && !self->done) {
+            pthread_cond_wait(&self->cond, &self->lock);
+        }
+
+        if (!self->pending) {
+            break;
+        }
+
+        struct trajectory_sample* samples = self->buffers[self->pending_index];
+        size_t len = self->pending_len;
+        int32_t failed = self->failed;
+
+        pthread_mutex_unlock(&self->lock);
+
+        struct timespec start;
+        struct timespec end;
+        struct timespec diff;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+
+        // once a write fails the remaining buffers are dropped so the
+        // simulation is never left waiting
+        if (!failed) {
+            failed = write_samples(self, samples, len);
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        timespec_diff(&start, &end, &diff);
+
+        pthread_mutex_lock(&self->lock);
+
+        timespec_add(&self->write_time, &diff, &self->write_time);
+        self->failed = failed;
+        self->pending = 0;
+
+        pthread_cond_broadcast(&self->cond);
+    }
+
+    pthread_mutex_unlock(&self->lock);
+
+    return NULL;
+}
+
+int32_t trajectory_writer_open(struct trajectory_writer* self, const char* file_path, int32_t format) {
+    self->format = format;
+    self->buffers[0] = NULL;
+    self->buffers[1] = NULL;
+    self->capacity = TRAJECTORY_BUFFER_LEN;
+    self->fill = 0;
+    self->fill_len = 0;
+    self->pending = 0;
+    self->pending_index = 0;
+    self->pending_len = 0;
+    self->done = 0;
+    self->failed = 0;
+    self->started = 0;
+    self->text = NULL;
+    self->text_capacity = 0;
+    self->samples = 0;
+    self->bytes = 0;
+    self->write_time.tv_sec = 0;
+    self->write_time.tv_nsec = 0;
+    self->stall_time.tv_sec = 0;
+    self->stall_time.tv_nsec = 0;
+
+    self->fd = open(file_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+    if (self->fd < 0) {
+        fprintf(stderr, "failed to create trajectory file \"%s\". %s\n", file_path, strerror(errno));
+
+        return 1;
+    }
+
+    for (int32_t index = 0; index < 2; index += 1) {
+        self->buffers[index] = (struct trajectory_sample*)malloc(
+            self->capacity * sizeof(struct trajectory_sample)
+        );
+
+        if (self->buffers[index] == NULL) {
+            fprintf(stderr, "failed allocating trajectory buffer. %s\n", strerror(errno));
+
+            trajectory_writer_close(self);
+
+            return 1;
+        }
+    }
+
+    if (format == TRAJECTORY_CSV) {
+        self->text_capacity = 1 << 20;
+        self->text = (char*)malloc(self->text_capacity);
+
+        if (self->text == NULL) {
+            fprintf(stderr, "failed allocating trajectory text buffer. %s\n", strerror(errno));
+
+            trajectory_writer_close(self);
+
+            return 1;
+        }
+
+        const char* header = "time,accel,vel,pos\n";
+
+        if (write_all(self->fd, header, strlen(header)) != 0) {
+            trajectory_writer_close(self);
+
+            return 1;
+        }
+
+        self->bytes += strlen(header);
+    } else {
+        struct trajectory_header header;
+
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, TRAJECTORY_MAGIC, TRAJECTORY_MAGIC_LEN);
+        header.version = swap_u32(TRAJECTORY_VERSION);
+        header.header_size = swap_u32(sizeof(header));
+        header.fields = swap_u32(sizeof(struct trajectory_sample) / sizeof(double));
+
+        if (write_all(self->fd, &header, sizeof(header)) != 0) {
+            trajectory_writer_close(self);
+
+            return 1;
+        }
+
+        self->bytes += sizeof(header);
+    }
+
+    pthread_mutex_init(&self->lock, NULL);
+    pthread_cond_init(&self->cond, NULL);
+
+    int rtn = pthread_create(&self->thread, NULL, trajectory_writer_thread, self);
+
+    if (rtn != 0) {
+        fprintf(stderr, "failed to start trajectory writer thread. %s\n", strerror(rtn));
+
+        pthread_cond_destroy(&self->cond);
+        pthread_mutex_destroy(&self->lock);
+        trajectory_writer_close(self);
+
+        return 1;
+    }
+
+    self->started = 1;
+
+    return 0;
+}
+
+// hands the filled buffer to the writer thread and switches to the other one,
+// waiting only if the writer thread has not finished with it yet
+static int32_t trajectory_writer_swap(struct trajectory_writer* self) {
+    struct timespec start;
+    struct timespec end;
+    struct timespec diff;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    pthread_mutex_lock(&self->lock);
+
+    while (self->pending) {
+        pthread_cond_wait(&self->cond, &self->lock);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    self->pending_index = self->fill;
+    self->pending_len = self->fill_len;
+    self->pending = 1;
+
+    int32_t failed = self->failed;
+
+    pthread_cond_broadcast(&self->cond);
+    pthread_mutex_unlock(&self->lock);
+
+    timespec_diff(&start, &end, &diff);
+    timespec_add(&self->stall_time, &diff, &self->stall_time);
+
+    self->fill ^= 1;
+    self->fill_len = 0;
+
+    return failed;
+}
+
+// returns the unused space of the buffer being filled. the simulation writes
+// samples directly into it and then commits them
+struct trajectory_sample* trajectory_writer_reserve(struct trajectory_writer* self, size_t* available) {
+    *available = self->capacity - self->fill_len;
+
+    return self->buffers[self->fill] + self->fill_len;
+}
+
+int32_t trajectory_writer_commit(struct trajectory_writer* self, size_t count) {
+    self->fill_len += count;
+    self->samples += count;
+
+    if (self->fill_len == self->capacity) {
+        return trajectory_writer_swap(self);
+    }
+
+    return 0;
+}
+
+// writes any remaining samples, waits for the writer thread to finish and
+// closes the file. returns non zero if any part of the trajectory failed to
+// be written
+int32_t trajectory_writer_close(struct trajectory_writer* self) {
+    int32_t failed = 0;
+
+    if (self->started) {
+        if (self->fill_len > 0) {
+            trajectory_writer_swap(self);
+        }
+
+        pthread_mutex_lock(&self->lock);
+        self->done = 1;
+        pthread_cond_broadcast(&self->cond);
+        pthread_mutex_unlock(&self->lock);
+
+        pthread_join(self->thread, NULL);
+
+        failed = self->failed;
+
+        pthread_cond_destroy(&self->cond);
+        pthread_mutex_destroy(&self->lock);
+
+        self->started = 0;
+    }
+
+    if (self->fd >= 0) {
+        if (close(self->fd) != 0) {
+            fprintf(stderr, "failed closing trajectory file. %s\n", strerror(errno));
+
+            failed = 1;
+        }
+
+        self->fd = -1;
+    }
+
+    free(self->buffers[0]);
+    free(self->buffers[1]);
+    free(self->text);
+
+    self->buffers[0] = NULL;
+    self->buffers[1] = NULL;
+    self->text = NULL;
+
+    return failed;
+}
+
+void trajectory_writer_print(struct trajectory_writer* self) {
+    printf(
+        "trajectory: %lu samples %.3lf MB write: %ld.%.9ld stall: %ld.%.9ld\n",
+        (unsigned long)self->samples,
+        (double)self->bytes / (1024.0 * 1024.0),
+        self->write_time.tv_sec,
+        self->write_time.tv_nsec,
+        self->stall_time.tv_sec,
+        self->stall_time.tv_nsec
+    );
+}
@@ -0,0 +1,85 @@
+#ifndef TRAJECTORY_H
+#define TRAJECTORY_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+// 8 byte identifier at the start of every binary trajectory file
+#define TRAJECTORY_MAGIC "TSIMTRJ\0"
+#define TRAJECTORY_MAGIC_LEN 8
+#define TRAJECTORY_VERSION 1
+
+// the number of samples in each of the two buffers
+#define TRAJECTORY_BUFFER_LEN (1 << 16)
+
+// on disk header for binary trajectories. all fields are stored little-endian
+// and the number of samples is the remaining size of the file divided by the
+// size of a sample since it is not known until the simulation finishes.
+//
+// | magic (8) | version (4) | header_size (4) | fields (4) | reserved (4) |
+// | samples of fields * double ...                                        |
+struct trajectory_header {
+    char magic[TRAJECTORY_MAGIC_LEN];
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t fields;
+    uint32_t reserved;
+};
+
+// the state of the train at the end of a single interval of the table
+struct trajectory_sample {
+    double time;
+    double accel;
+    double vel;
+    double pos;
+};
+
+// writes samples to a file from a dedicated thread. the simulation fills one
+// buffer while the writer thread is writing the other so the simulation only
+// waits when it fills a buffer before the previous one has been written.
+struct trajectory_writer {
+    int fd;
+    int32_t format;
+
+    struct trajectory_sample* buffers[2];
+    size_t capacity;
+
+    // the buffer being filled by the simulation
+    int32_t fill;
+    size_t fill_len;
+
+    // the buffer handed off to the writer thread. pending is set while the
+    // writer thread still owns it
+    int32_t pending;
+    int32_t pending_index;
+    size_t pending_len;
+    int32_t done;
+    int32_t failed;
+
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    pthread_t thread;
+    int32_t started;
+
+    // formatting buffer for csv output, only used by the writer thread
+    char* text;
+    size_t text_capacity;
+
+    uint64_t samples;
+    uint64_t bytes;
+    // time the writer thread spent writing and the time the simulation spent
+    // waiting for a buffer to be written
+    struct timespec write_time;
+    struct timespec stall_time;
+};
+
+int32_t trajectory_writer_open(struct trajectory_writer* self, const char* file_path, int32_t format);
+int32_t trajectory_writer_close(struct trajectory_writer* self);
+void trajectory_writer_print(struct trajectory_writer* self);
+
+struct trajectory_sample* trajectory_writer_reserve(struct trajectory_writer* self, size_t* available);
+int32_t trajectory_writer_commit(struct trajectory_writer* self, size_t count);
+
+#endif
@@ -1,4 +1,12 @@
+#include <errno.h>
 #include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
 
 #include "ts.h"
 
@@ -13,19 +21,34 @@ void timing_init(struct timing* init) {
 }
 
 void timing_update(struct timing* self, struct timespec* given) {
-    time_min(&self->min, given, &self->min);
-    time_max(&self->max, given, &self->max);
+    timespec_min(&self->min, given, &self->min);
+    timespec_max(&self->max, given, &self->max);
 
-    time_add(&self->total, given, &self->total);
+    timespec_add(&self->total, given, &self->total);
 
     self->count += 1;
 }
 
+// combines the timings of another set of runs into this one, such as the
+// timings of each rank of a distributed run
+void timing_merge(struct timing* self, struct timing* other) {
+    if (other->count == 0) {
+        return;
+    }
+
+    timespec_min(&self->min, &other->min, &self->min);
+    timespec_max(&self->max, &other->max, &self->max);
+
+    timespec_add(&self->total, &other->total, &self->total);
+
+    self->count += other->count;
+}
+
 void timing_print(struct timing* self) {
     if (self->count > 1) {
         struct timespec avg;
 
-        if (time_div(&self->total, self->count, &avg) != 0) {
+        if (timespec_div(&self->total, self->count, &avg) != 0) {
             printf("bad nanos calculated\n");
 
             return;
@@ -47,6 +70,404 @@ void timing_print(struct timing* self) {
     }
 }
 
+void histogram_init(struct histogram* self) {
+    memset(self->counts, 0, sizeof(self->counts));
+    self->count = 0;
+}
+
+static int32_t histogram_bucket(uint64_t nanos) {
+    if (nanos < HISTOGRAM_SUB_BUCKETS) {
+        return (int32_t)nanos;
+    }
+
+    int32_t magnitude = 63 - __builtin_clzll(nanos);
+    int32_t shift = magnitude - HISTOGRAM_SUB_BITS;
+    int32_t sub = (int32_t)((nanos >> shift) & (HISTOGRAM_SUB_BUCKETS - 1));
+
+    return (shift + 1) * HISTOGRAM_SUB_BUCKETS + sub;
+}
+
+// the middle of the range of values that land in the bucket
+static uint64_t histogram_value(int32_t bucket) {
+    if (bucket < HISTOGRAM_SUB_BUCKETS) {
+        return (uint64_t)bucket;
+    }
+
+    int32_t shift = bucket / HISTOGRAM_SUB_BUCKETS - 1;
+    uint64_t sub = (uint64_t)(bucket % HISTOGRAM_SUB_BUCKETS);
+    uint64_t lower = (HISTOGRAM_SUB_BUCKETS + sub) << shift;
+
+    return lower + ((1ull << shift) >> 1);
+}
+
+void histogram_record(struct histogram* self, uint64_t nanos) {
+    self->counts[histogram_bucket(nanos)] += 1;
+    self->count += 1;
+}
+
+// the value that the given fraction of the recorded values are at or below
+uint64_t histogram_percentile(struct histogram* self, double percentile) {
+    if (self->count == 0) {
+        return 0;
+    }
+
+    uint64_t target = (uint64_t)(percentile * (double)self->count + 0.5);
+    uint64_t seen = 0;
+
+    if (target == 0) {
+        target = 1;
+    }
+
+    for (int32_t bucket = 0; bucket < HISTOGRAM_BUCKETS; bucket += 1) {
+        seen += self->counts[bucket];
+
+        if (seen >= target) {
+            return histogram_value(bucket);
+        }
+    }
+
+    return histogram_value(HISTOGRAM_BUCKETS - 1);
+}
+
+#if defined(__linux__)
+
+static int perf_open(uint32_t type, uint64_t config) {
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+// opens the counters for this process and any threads it creates after this.
+// fails when the kernel or the hardware does not provide one of them, which
+// is common in virtual machines or with a strict perf_event_paranoid.
+static int32_t perf_open_counters(int* fds) {
+    const uint64_t configs[PERF_COUNTER_COUNT] = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES,
+        PERF_COUNT_HW_BRANCH_MISSES
+    };
+
+    for (int32_t counter = 0; counter < PERF_COUNTER_COUNT; counter += 1) {
+        fds[counter] = perf_open(PERF_TYPE_HARDWARE, configs[counter]);
+
+        if (fds[counter] < 0) {
+            fprintf(stderr, "failed to open hardware counters, continuing without them. %s\n", strerror(errno));
+
+            for (int32_t prev = 0; prev < counter; prev += 1) {
+                close(fds[prev]);
+                fds[prev] = -1;
+            }
+
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static void perf_read_counters(const int* fds, uint64_t* values) {
+    for (int32_t counter = 0; counter < PERF_COUNTER_COUNT; counter += 1) {
+        uint64_t value = 0;
+
+        if (read(fds[counter], &value, sizeof(value)) != sizeof(value)) {
+            value = 0;
+        }
+
+        values[counter] = value;
+    }
+}
+
+#else
+
+static int32_t perf_open_counters(int* fds) {
+    (void)fds;
+
+    fprintf(stderr, "hardware counters are only available on linux, continuing without them\n");
+
+    return 1;
+}
+
+static void perf_read_counters(const int* fds, uint64_t* values) {
+    (void)fds;
+
+    memset(values, 0, sizeof(uint64_t) * PERF_COUNTER_COUNT);
+}
+
+#endif
+
+void profiler_init(struct profiler* self, int32_t enabled, int32_t cycles, int32_t perf) {
+    self->enabled = enabled;
+    self->cycles = cycles;
+    self->perf = 0;
+    self->samples = 0;
+
+    for (int32_t counter = 0; counter < PERF_COUNTER_COUNT; counter += 1) {
+        self->perf_fds[counter] = -1;
+        self->mark_perf[counter] = 0;
+        self->begin_perf[counter] = 0;
+    }
+
+    for (int32_t phase = 0; phase < PHASE_COUNT; phase += 1) {
+        timing_init(&self->phases[phase].timing);
+        histogram_init(&self->phases[phase].hist);
+        self->phases[phase].cycles = 0;
+        self->phases[phase].samples = 0;
+        memset(self->phases[phase].perf, 0, sizeof(self->phases[phase].perf));
+    }
+
+    self->mark.tv_sec = 0;
+    self->mark.tv_nsec = 0;
+    self->mark_cycles = 0;
+    self->begin = self->mark;
+    self->begin_cycles = 0;
+
+    if (enabled && perf && perf_open_counters(self->perf_fds) == 0) {
+        self->perf = 1;
+    }
+}
+
+void profiler_free(struct profiler* self) {
+    for (int32_t counter = 0; counter < PERF_COUNTER_COUNT; counter += 1) {
+        if (self->perf_fds[counter] >= 0) {
+            close(self->perf_fds[counter]);
+            self->perf_fds[counter] = -1;
+        }
+    }
+
+    self->perf = 0;
+}
+
+const char* profiler_phase_name(int32_t phase) {
+    switch (phase) {
+    case PHASE_VELOCITY:
+        return "velocity";
+    case PHASE_SCAN:
+        return "scan";
+    case PHASE_POSITION:
+        return "position";
+    case PHASE_FUSED:
+        return "fused";
+    case PHASE_JOIN:
+        return "join";
+    case PHASE_ITERATION:
+        return "iteration";
+    default:
+        return "unknown";
+    }
+}
+
+// starts a new iteration at the current point
+void profiler_mark(struct profiler* self) {
+    clock_gettime(CLOCK_MONOTONIC, &self->mark);
+    self->mark_cycles = self->cycles ? ts_cycles() : 0;
+
+    if (self->perf) {
+        perf_read_counters(self->perf_fds, self->mark_perf);
+    }
+
+    self->begin = self->mark;
+    self->begin_cycles = self->mark_cycles;
+    memcpy(self->begin_perf, self->mark_perf, sizeof(self->begin_perf));
+}
+
+// adds everything from the start of the current phase, or of the whole
+// iteration, until now to the phase and moves the phase mark to now
+void profiler_record(struct profiler* self, int32_t phase, int32_t whole) {
+    struct phase_timer* timer = &self->phases[phase];
+    struct timespec* start = whole ? &self->begin : &self->mark;
+    uint64_t* start_perf = whole ? self->begin_perf : self->mark_perf;
+    uint64_t start_cycles = whole ? self->begin_cycles : self->mark_cycles;
+    struct timespec now;
+    struct timespec diff;
+    uint64_t now_perf[PERF_COUNTER_COUNT];
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    uint64_t now_cycles = self->cycles ? ts_cycles() : 0;
+
+    if (self->perf) {
+        perf_read_counters(self->perf_fds, now_perf);
+
+        for (int32_t counter = 0; counter < PERF_COUNTER_COUNT; counter += 1) {
+            timer->perf[counter] += now_perf[counter] - start_perf[counter];
+        }
+    } else {
+        memset(now_perf, 0, sizeof(now_perf));
+    }
+
+    timespec_diff(start, &now, &diff);
+    timing_update(&timer->timing, &diff);
+    histogram_record(&timer->hist, (uint64_t)diff.tv_sec * 1000000000ull + (uint64_t)diff.tv_nsec);
+    timer->cycles += now_cycles - start_cycles;
+    timer->samples += self->samples;
+
+    self->mark = now;
+    self->mark_cycles = now_cycles;
+    memcpy(self->mark_perf, now_perf, sizeof(self->mark_perf));
+}
+
+static uint64_t timespec_nanos(struct timespec* value) {
+    return (uint64_t)value->tv_sec * 1000000000ull + (uint64_t)value->tv_nsec;
+}
+
+void profiler_print(struct profiler* self) {
+    if (!self->enabled) {
+        return;
+    }
+
+    for (int32_t phase = 0; phase < PHASE_COUNT; phase += 1) {
+        struct phase_timer* timer = &self->phases[phase];
+
+        if (timer->timing.count == 0) {
+            continue;
+        }
+
+        printf(
+            "phase: %s count: %u avg: %luns p50: %luns p90: %luns p99: %luns p99.9: %luns",
+            profiler_phase_name(phase),
+            timer->timing.count,
+            (unsigned long)(timespec_nanos(&timer->timing.total) / timer->timing.count),
+            (unsigned long)histogram_percentile(&timer->hist, 0.5),
+            (unsigned long)histogram_percentile(&timer->hist, 0.9),
+            (unsigned long)histogram_percentile(&timer->hist, 0.99),
+            (unsigned long)histogram_percentile(&timer->hist, 0.999)
+        );
+
+        if (self->cycles) {
+            printf(" cycles: %lu", (unsigned long)(timer->cycles / timer->timing.count));
+        }
+
+        if (self->perf) {
+            double samples = timer->samples > 0 ? (double)timer->samples : 1.0;
+
+            printf(
+                " ipc: %.3lf llc-misses/sample: %.4lf branch-misses/sample: %.4lf",
+                timer->perf[PERF_CYCLES] > 0
+                    ? (double)timer->perf[PERF_INSTRUCTIONS] / (double)timer->perf[PERF_CYCLES]
+                    : 0.0,
+                (double)timer->perf[PERF_LLC_MISSES] / samples,
+                (double)timer->perf[PERF_BRANCH_MISSES] / samples
+            );
+        }
+
+        printf("\n");
+    }
+}
+
+// writes every phase that was timed to the given file as csv with a header
+// row or as a json array. all times are in nanoseconds and cycles is the
+// average per call, or 0 when cycles were not counted. the hardware counters
+// are also averages per call and are 0 when they were not opened. csv is non
+// zero for csv and zero for json.
+int32_t profiler_write(struct profiler* self, const char* file_path, int32_t csv) {
+    FILE* file = fopen(file_path, "w");
+
+    if (file == NULL) {
+        fprintf(stderr, "failed to create profile output \"%s\". %s\n", file_path, strerror(errno));
+
+        return 1;
+    }
+
+    if (csv) {
+        fprintf(file, "phase,count,min,max,avg,total,p50,p90,p99,p999,cycles,hw_cycles,instructions,llc_misses,branch_misses\n");
+    } else {
+        fprintf(file, "[");
+    }
+
+    int32_t written = 0;
+
+    for (int32_t phase = 0; phase < PHASE_COUNT; phase += 1) {
+        struct phase_timer* timer = &self->phases[phase];
+        uint32_t count = timer->timing.count;
+
+        if (count == 0) {
+            continue;
+        }
+
+        unsigned long min = (unsigned long)timespec_nanos(&timer->timing.min);
+        unsigned long max = (unsigned long)timespec_nanos(&timer->timing.max);
+        unsigned long total = (unsigned long)timespec_nanos(&timer->timing.total);
+        unsigned long p50 = (unsigned long)histogram_percentile(&timer->hist, 0.5);
+        unsigned long p90 = (unsigned long)histogram_percentile(&timer->hist, 0.9);
+        unsigned long p99 = (unsigned long)histogram_percentile(&timer->hist, 0.99);
+        unsigned long p999 = (unsigned long)histogram_percentile(&timer->hist, 0.999);
+        unsigned long cycles = (unsigned long)(timer->cycles / count);
+        unsigned long hw_cycles = (unsigned long)(timer->perf[PERF_CYCLES] / count);
+        unsigned long instructions = (unsigned long)(timer->perf[PERF_INSTRUCTIONS] / count);
+        unsigned long llc_misses = (unsigned long)(timer->perf[PERF_LLC_MISSES] / count);
+        unsigned long branch_misses = (unsigned long)(timer->perf[PERF_BRANCH_MISSES] / count);
+
+        if (csv) {
+            fprintf(
+                file,
+                "%s,%u,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu\n",
+                profiler_phase_name(phase),
+                count,
+                min,
+                max,
+                total / count,
+                total,
+                p50,
+                p90,
+                p99,
+                p999,
+                cycles,
+                hw_cycles,
+                instructions,
+                llc_misses,
+                branch_misses
+            );
+        } else {
+            fprintf(
+                file,
+                "%s\n  {\"phase\":\"%s\",\"count\":%u,\"min\":%lu,\"max\":%lu,"
+                "\"avg\":%lu,\"total\":%lu,\"p50\":%lu,\"p90\":%lu,\"p99\":%lu,"
+                "\"p999\":%lu,\"cycles\":%lu,\"hw_cycles\":%lu,\"instructions\":%lu,"
+                "\"llc_misses\":%lu,\"branch_misses\":%lu}",
+                written > 0 ? "," : "",
+                profiler_phase_name(phase),
+                count,
+                min,
+                max,
+                total / count,
+                total,
+                p50,
+                p90,
+                p99,
+                p999,
+                cycles,
+                hw_cycles,
+                instructions,
+                llc_misses,
+                branch_misses
+            );
+        }
+
+        written += 1;
+    }
+
+    if (!csv) {
+        fprintf(file, "\n]\n");
+    }
+
+    if (fclose(file) != 0) {
+        fprintf(stderr, "failed writing profile output \"%s\". %s\n", file_path, strerror(errno));
+
+        return 1;
+    }
+
+    return 0;
+}
+
 int32_t log_timer_init(struct log_timer* self) {
     if (clock_gettime(CLOCK_MONOTONIC, &self->prev) != 0) {
         return 1;
@@ -66,9 +487,9 @@ int32_t log_timer_update(struct log_timer* self) {
         return -1;
     }
 
-    time_diff(&self->prev, &now, &diff);
+    timespec_diff(&self->prev, &now, &diff);
 
-    if (time_ge(&diff, &self->dur)) {
+    if (timespec_ge(&diff, &self->dur)) {
         self->prev.tv_sec = now.tv_sec;
         self->prev.tv_nsec = now.tv_nsec;
 
@@ -78,7 +499,7 @@ int32_t log_timer_update(struct log_timer* self) {
     }
 }
 
-void time_diff(struct timespec* start, struct timespec* end, struct timespec* diff) {
+void timespec_diff(struct timespec* start, struct timespec* end, struct timespec* diff) {
     time_t tv_sec = end->tv_sec - start->tv_sec;
     long tv_nsec = end->tv_nsec - start->tv_nsec;
 
@@ -91,7 +512,7 @@ void time_diff(struct timespec* start, struct timespec* end, struct timespec* di
     diff->tv_nsec = tv_nsec;
 }
 
-void time_min(struct timespec* l, struct timespec* r, struct timespec* min) {
+void timespec_min(struct timespec* l, struct timespec* r, struct timespec* min) {
     if (l->tv_sec > r->tv_sec) {
         min->tv_sec = r->tv_sec;
         min->tv_nsec = r->tv_nsec;
@@ -109,7 +530,7 @@ void time_min(struct timespec* l, struct timespec* r, struct timespec* min) {
     }
 }
 
-void time_max(struct timespec* l, struct timespec* r, struct timespec* max) {
+void timespec_max(struct timespec* l, struct timespec* r, struct timespec* max) {
     if (l->tv_sec < r->tv_sec) {
         max->tv_sec = r->tv_sec;
         max->tv_nsec = r->tv_nsec;
@@ -127,7 +548,7 @@ void time_max(struct timespec* l, struct timespec* r, struct timespec* max) {
     }
 }
 
-void time_add(struct timespec* l, struct timespec* r, struct timespec* add) {
+void timespec_add(struct timespec* l, struct timespec* r, struct timespec* add) {
     time_t tv_sec = l->tv_sec + r->tv_sec;
     long tv_nsec = l->tv_nsec + r->tv_nsec;
 
@@ -140,7 +561,7 @@ void time_add(struct timespec* l, struct timespec* r, struct timespec* add) {
     add->tv_nsec = tv_nsec;
 }
 
-int32_t time_div(struct timespec* l, uint32_t count, struct timespec* div) {
+int32_t timespec_div(struct timespec* l, uint32_t count, struct timespec* div) {
     if (count != 0) {
         time_t secs = l->tv_sec / count;
         time_t secs_extra = l->tv_sec % count;
@@ -162,7 +583,7 @@ int32_t time_div(struct timespec* l, uint32_t count, struct timespec* div) {
     }
 }
 
-int32_t time_eq(struct timespec* l, struct timespec* r) {
+int32_t timespec_eq(struct timespec* l, struct timespec* r) {
     if (l->tv_sec == r->tv_sec) {
         return l->tv_nsec == r->tv_nsec;
     } else {
@@ -170,7 +591,7 @@ int32_t time_eq(struct timespec* l, struct timespec* r) {
     }
 }
 
-int32_t time_ge(struct timespec* l, struct timespec* r) {
+int32_t timespec_ge(struct timespec* l, struct timespec* r) {
     if (l->tv_sec > r->tv_sec) {
         return 1;
     } else if (l->tv_sec == r->tv_sec) {
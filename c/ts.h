@@ -4,6 +4,10 @@
 #include <stdint.h>
 #include <time.h>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
 struct timing {
     struct timespec min;
     struct timespec max;
@@ -18,17 +22,145 @@ struct log_timer {
 
 void timing_init(struct timing* init);
 void timing_update(struct timing* self, struct timespec* given);
+void timing_merge(struct timing* self, struct timing* other);
 void timing_print(struct timing* self);
 
 int32_t log_timer_init(struct log_timer* self);
 int32_t log_timer_update(struct log_timer* self);
 
-void time_diff(struct timespec* start, struct timespec* end, struct timespec* diff);
-void time_min(struct timespec* l, struct timespec* r, struct timespec* min);
-void time_max(struct timespec* l, struct timespec* r, struct timespec* max);
-void time_add(struct timespec* l, struct timespec* r, struct timespec* add);
-int32_t time_div(struct timespec* l, uint32_t count, struct timespec* div);
-int32_t time_eq(struct timespec* l, struct timespec* r);
-int32_t time_ge(struct timespec* l, struct timespec* r);
+// the phases of a simulation that the profiler keeps timings for. iteration
+// covers the whole of each run.
+enum PHASE {
+    PHASE_VELOCITY = 0,
+    PHASE_SCAN = 1,
+    PHASE_POSITION = 2,
+    PHASE_FUSED = 3,
+    PHASE_JOIN = 4,
+    PHASE_ITERATION = 5,
+    PHASE_COUNT = 6
+};
+
+// log linear latency histogram in nanoseconds. values below
+// HISTOGRAM_SUB_BUCKETS land in their own bucket and every power of two above
+// that is split into HISTOGRAM_SUB_BUCKETS buckets, keeping the error of any
+// recorded value under 1 / HISTOGRAM_SUB_BUCKETS.
+#define HISTOGRAM_SUB_BITS 4
+#define HISTOGRAM_SUB_BUCKETS (1 << HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_BUCKETS ((64 - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB_BUCKETS)
+
+struct histogram {
+    uint64_t counts[HISTOGRAM_BUCKETS];
+    uint64_t count;
+};
+
+// hardware counters read around each phase by the profiler when they are
+// enabled and the kernel allows it
+enum PERF_COUNTER {
+    PERF_CYCLES = 0,
+    PERF_INSTRUCTIONS = 1,
+    PERF_LLC_MISSES = 2,
+    PERF_BRANCH_MISSES = 3,
+    PERF_COUNTER_COUNT = 4
+};
+
+struct phase_timer {
+    struct timing timing;
+    struct histogram hist;
+    uint64_t cycles;
+    // the entries of the table processed while in the phase
+    uint64_t samples;
+    uint64_t perf[PERF_COUNTER_COUNT];
+};
+
+// per phase timings of a simulation. everything is skipped when the profiler
+// is not enabled so the runners can call it unconditionally.
+struct profiler {
+    int32_t enabled;
+    // also read the time stamp counter at every mark
+    int32_t cycles;
+    // also read the hardware counters at every mark. the counters are
+    // inherited by threads created after they are opened so the profiler
+    // has to be set up before the first parallel region to count the
+    // OpenMP workers.
+    int32_t perf;
+    int perf_fds[PERF_COUNTER_COUNT];
+
+    struct phase_timer phases[PHASE_COUNT];
+
+    // entries of the table processed by each iteration
+    uint64_t samples;
+
+    // the start of the current phase and of the current iteration
+    struct timespec mark;
+    uint64_t mark_cycles;
+    uint64_t mark_perf[PERF_COUNTER_COUNT];
+    struct timespec begin;
+    uint64_t begin_cycles;
+    uint64_t begin_perf[PERF_COUNTER_COUNT];
+};
+
+// reads the time stamp counter of the cpu, or 0 where there is none. on x86
+// this ticks at a constant reference rate and not the current clock speed.
+static inline uint64_t ts_cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    uint64_t value;
+
+    __asm__ volatile("mrs %0, cntvct_el0" : "=r"(value));
+
+    return value;
+#else
+    return 0;
+#endif
+}
+
+void histogram_init(struct histogram* self);
+void histogram_record(struct histogram* self, uint64_t nanos);
+uint64_t histogram_percentile(struct histogram* self, double percentile);
+
+void profiler_init(struct profiler* self, int32_t enabled, int32_t cycles, int32_t perf);
+void profiler_free(struct profiler* self);
+const char* profiler_phase_name(int32_t phase);
+void profiler_mark(struct profiler* self);
+void profiler_record(struct profiler* self, int32_t phase, int32_t whole);
+void profiler_print(struct profiler* self);
+int32_t profiler_write(struct profiler* self, const char* file_path, int32_t csv);
+
+// starts a new iteration and the first phase of it
+static inline void profiler_start(struct profiler* self) {
+    if (!self->enabled) {
+        return;
+    }
+
+    profiler_mark(self);
+}
+
+// ends the current phase and starts the next one from the same point. when
+// called from a parallel region only one thread may call it between barriers.
+static inline void profiler_lap(struct profiler* self, int32_t phase) {
+    if (!self->enabled) {
+        return;
+    }
+
+    profiler_record(self, phase, 0);
+}
+
+// ends the current iteration
+static inline void profiler_finish(struct profiler* self) {
+    if (!self->enabled) {
+        return;
+    }
+
+    profiler_record(self, PHASE_ITERATION, 1);
+}
+
+void timespec_diff(struct timespec* start, struct timespec* end, struct timespec* diff);
+void timespec_min(struct timespec* l, struct timespec* r, struct timespec* min);
+void timespec_max(struct timespec* l, struct timespec* r, struct timespec* max);
+void timespec_add(struct timespec* l, struct timespec* r, struct timespec* add);
+int32_t timespec_div(struct timespec* l, uint32_t count, struct timespec* div);
+int32_t timespec_eq(struct timespec* l, struct timespec* r);
+int32_t timespec_ge(struct timespec* l, struct timespec* r);
 
 #endif